@@ -0,0 +1,43 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+// Counts every heap allocation made through operator new, so a tool can
+// report how many allocations a phase performed. This replaces the global
+// operator new/delete, so include it from exactly one .cpp per program.
+
+inline std::atomic<size_t>& heap_allocation_count() {
+    static std::atomic<size_t> count{0};
+    return count;
+}
+
+void* operator new(std::size_t size) {
+    heap_allocation_count().fetch_add(1, std::memory_order_relaxed);
+    if (size == 0)
+        size = 1;
+    if (void* p = std::malloc(size))
+        return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+    return operator new(size);
+}
+
+// GCC cannot tell these replacements pair malloc with free and warns about a mismatch
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
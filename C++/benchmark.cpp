@@ -0,0 +1,420 @@
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <iomanip>
+#include <algorithm>
+#include <functional>
+#include <random>
+#include <cmath>
+#include "cli_options.hpp"
+#include "csv_loader.hpp"
+#include "eytzinger_index.hpp"
+#include "introsort.hpp"
+#include "key_index_sort.hpp"
+#include "key_search.hpp"
+#include "parallel_merge_sort.hpp"
+#include "parallel_radix_sort.hpp"
+#include "probe_search.hpp"
+#include "radix_sort.hpp"
+#include "sort_search.hpp"
+
+using namespace std;
+using namespace std::chrono;
+
+// Keep a value alive as far as the optimiser can tell, so a result that is
+// never used cannot make the work that produced it disappear
+template <typename T>
+inline void do_not_optimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+// Stop the compiler from moving memory accesses across a timer read
+inline void clobber_memory() {
+    asm volatile("" : : : "memory");
+}
+
+// Summary of the trial times of one engine on one input, in milliseconds
+struct TrialStats {
+    double min = 0, median = 0, p95 = 0, mean = 0;
+    double ci_low = 0, ci_high = 0;   // 95% confidence interval of the mean
+};
+
+// Two-sided 95% Student t quantiles for 1..30 degrees of freedom
+const double kStudentT95[30] = {12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+                                2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+                                2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042};
+
+TrialStats summarize(vector<double> times) {
+    TrialStats stats;
+    sort(times.begin(), times.end());
+    size_t k = times.size();
+    stats.min = times.front();
+    stats.median = (k % 2) ? times[k / 2] : (times[k / 2 - 1] + times[k / 2]) / 2;
+    stats.p95 = times[static_cast<size_t>(ceil(0.95 * k)) - 1];   // Nearest rank
+    for (double t : times)
+        stats.mean += t;
+    stats.mean /= k;
+
+    double variance = 0;
+    for (double t : times)
+        variance += (t - stats.mean) * (t - stats.mean);
+    double half_width = 0;
+    if (k > 1) {
+        variance /= (k - 1);
+        double t = (k - 1 <= 30) ? kStudentT95[k - 2] : 1.96;
+        half_width = t * sqrt(variance / k);
+    }
+    stats.ci_low = stats.mean - half_width;
+    stats.ci_high = stats.mean + half_width;
+    return stats;
+}
+
+// One line of results
+struct BenchmarkResult {
+    string kind;           // sort or search
+    string engine;
+    string distribution;
+    size_t size = 0;       // Records in the input
+    size_t operations = 0; // Records sorted or queries answered per trial
+    size_t trials = 0;
+    TrialStats stats;
+};
+
+// Runs every sort and search engine over generated inputs: for each size and
+// key distribution, an engine gets `warmup` untimed runs and `trials` timed
+// ones, each on a fresh copy of the input (the copy is not timed). Sort
+// results are checked once; search results feed do_not_optimize.
+class Benchmark {
+public:
+    // Optional arguments:
+    //   --sizes=N,...          record counts to sweep (default 1000,10000,100000,1000000)
+    //   --distributions=D,...  random, sorted, reversed, few-unique (default: all)
+    //   --engines=E,...        engines to run (default: all; see sort_engines and search_engines)
+    //   --trials=N             timed runs per engine and input (default 10)
+    //   --warmup=N             untimed runs before the trials (default 2)
+    //   --threads=N            threads for the parallel engines (default: one per core)
+    //   --seed=N               input generator seed (default 42)
+    //   --format=csv|json      result file format (default csv)
+    //   --output=FILE          result file (default benchmark_results.csv or .json)
+    void main(int argc, char* argv[]) {
+        vector<string> size_list = option_list(argc, argv, "sizes", "1000,10000,100000,1000000");
+        vector<string> distributions = option_list(argc, argv, "distributions", "random,sorted,reversed,few-unique");
+        string engine_option = option_value(argc, argv, "engines");
+        trials = static_cast<size_t>(max(1L, option_number(argc, argv, "trials", 10)));
+        warmup = static_cast<size_t>(max(0L, option_number(argc, argv, "warmup", 2)));
+        unsigned threads;
+        if (!option_threads(argc, argv, threads)) {
+            cerr << "Error: Invalid thread count '" << option_value(argc, argv, "threads") << "'." << endl;
+            return;
+        }
+        seed = static_cast<unsigned>(option_number(argc, argv, "seed", 42));
+        string format = option_value(argc, argv, "format", "csv");
+        string output_filename = option_value(argc, argv, "output", "benchmark_results." + format);
+
+        if (format != "csv" && format != "json") {
+            cerr << "Error: Unknown result format '" << format << "'." << endl;
+            return;
+        }
+        vector<size_t> sizes;
+        for (const string& item : size_list) {
+            char* end = nullptr;
+            double size = strtod(item.c_str(), &end);    // Accepts 1e6 as well as 1000000
+            if (item.empty() || *end != '\0' || size < 1) {
+                cerr << "Error: Invalid size '" << item << "'." << endl;
+                return;
+            }
+            sizes.push_back(static_cast<size_t>(size));
+        }
+        for (const string& distribution : distributions) {
+            if (distribution != "random" && distribution != "sorted" && distribution != "reversed" &&
+                distribution != "few-unique") {
+                cerr << "Error: Unknown distribution '" << distribution << "'." << endl;
+                return;
+            }
+        }
+
+        ThreadPool pool(threads);
+        auto sorts = sort_engines(pool);
+        auto searches = search_engines();
+        if (!engine_option.empty()) {
+            vector<string> wanted = option_list(argc, argv, "engines");
+            for (const string& name : wanted) {
+                bool known = any_of(sorts.begin(), sorts.end(), [&](const SortEngine& e) { return e.first == name; }) ||
+                             any_of(searches.begin(), searches.end(), [&](const SearchEngine& e) { return e.first == name; });
+                if (!known) {
+                    cerr << "Error: Unknown engine '" << name << "'." << endl;
+                    return;
+                }
+            }
+            auto unwanted = [&](const string& name) { return find(wanted.begin(), wanted.end(), name) == wanted.end(); };
+            sorts.erase(remove_if(sorts.begin(), sorts.end(), [&](const SortEngine& e) { return unwanted(e.first); }), sorts.end());
+            searches.erase(remove_if(searches.begin(), searches.end(), [&](const SearchEngine& e) { return unwanted(e.first); }), searches.end());
+        }
+
+        cout << fixed << setprecision(3);
+        vector<BenchmarkResult> results;
+        for (size_t n : sizes) {
+            for (const string& distribution : distributions) {
+                Input input = generate(n, distribution);
+                for (const SortEngine& engine : sorts)
+                    if (distribution == "random" || !random_input_only(engine.first))
+                        results.push_back(run_sort(engine, input, distribution));
+
+                // Searches only see the sorted keys, which are the same for
+                // random, sorted and reversed input
+                if (distribution != "random" && distribution != "few-unique")
+                    continue;
+                SearchInput search_input = prepare_search(input);
+                for (const SearchEngine& engine : searches)
+                    results.push_back(run_search(engine, search_input, distribution));
+            }
+        }
+
+        if (!write_results(results, format, output_filename)) {
+            cerr << "An error occurred while writing the results: " << output_filename << endl;
+            return;
+        }
+        cout << "Results written to " << output_filename << endl;
+    }
+
+private:
+    // Generated records; the words live in `letters`
+    struct Input {
+        vector<char> letters;
+        vector<Record> rows;
+    };
+
+    // Sorted rows with their packed keys, an Eytzinger index and the queries
+    struct SearchInput {
+        vector<Record> rows;
+        vector<int32_t> keys;
+        EytzingerIndex eytzinger;
+        vector<int32_t> queries;
+    };
+
+    using SortEngine = pair<string, function<void(vector<Record>&)>>;
+    using SearchEngine = pair<string, function<long long(const SearchInput&, const vector<int32_t>&)>>;
+
+    size_t trials = 10;
+    size_t warmup = 2;
+    unsigned seed = 42;
+
+    // Sort engines: the library engines plus the standard library as a baseline.
+    // The classic quick sorts run on the random input only; see random_input_only.
+    vector<SortEngine> sort_engines(ThreadPool& pool) {
+        return {
+            {"std-sort", [](vector<Record>& v) {
+                 sort(v.begin(), v.end(), [](const Record& a, const Record& b) { return a.first < b.first; });
+             }},
+            {"std-stable-sort", [](vector<Record>& v) {
+                 stable_sort(v.begin(), v.end(), [](const Record& a, const Record& b) { return a.first < b.first; });
+             }},
+            {"merge-sort", [](vector<Record>& v) { merge_sort(v.begin(), v.end()); }},
+            {"buffered-merge-sort", [](vector<Record>& v) { buffered_merge_sort(v.begin(), v.end()); }},
+            {"adaptive-merge-sort", [](vector<Record>& v) { adaptive_merge_sort(v.begin(), v.end()); }},
+            {"keyindex-merge-sort", [](vector<Record>& v) {
+                 sort_by_key_index(v, [](vector<KeyIndex>& keys) { merge_sort(keys.begin(), keys.end()); });
+             }},
+            {"quick-sort", [](vector<Record>& v) { quick_sort<LomutoPartition>(v.begin(), v.end()); }},
+            {"block-quick-sort", [](vector<Record>& v) { quick_sort<BlockPartition>(v.begin(), v.end()); }},
+            {"keyindex-quick-sort", [](vector<Record>& v) {
+                 sort_by_key_index(v, [](vector<KeyIndex>& keys) { quick_sort<LomutoPartition>(keys.begin(), keys.end()); });
+             }},
+            {"introsort", [](vector<Record>& v) { IntroSort<Record>(nullptr, v.size()).sort(v); }},
+            {"introsort-parallel", [&pool](vector<Record>& v) { IntroSort<Record>(&pool, 16384).sort(v); }},
+            {"parallel-merge", [&pool](vector<Record>& v) { ParallelMergeSort<Record>(pool, 16384, 65536).sort(v); }},
+            {"keyindex-radix", [](vector<Record>& v) {
+                 sort_by_key_index(v, [](vector<KeyIndex>& keys) { lsd_radix_sort(keys); });
+             }},
+            {"lsd-radix", [](vector<Record>& v) { lsd_radix_sort(v); }},
+            {"parallel-radix", [&pool](vector<Record>& v) { ParallelRadixSort<Record>(pool).sort(v); }},
+        };
+    }
+
+    // The classic quick sort's last-element pivot goes quadratic, and recurses
+    // as deep as the input, on sorted, reversed and few-unique keys
+    static bool random_input_only(const string& engine) {
+        return engine.find("quick-sort") != string::npos;
+    }
+
+    // Search engines; each returns a checksum of the found rows
+    vector<SearchEngine> search_engines() {
+        return {
+            {"std-lower-bound", [](const SearchInput& in, const vector<int32_t>& queries) {
+                 long long checksum = 0;
+                 for (int32_t q : queries)
+                     checksum += lower_bound(in.rows.begin(), in.rows.end(), q,
+                                             [](const Record& r, int32_t key) { return r.first < key; }) - in.rows.begin();
+                 return checksum;
+             }},
+            {"binary-search", [](const SearchInput& in, const vector<int32_t>& queries) {
+                 long long checksum = 0;
+                 for (int32_t q : queries)
+                     checksum += binary_find(in.rows.begin(), in.rows.end(), q) - in.rows.begin();
+                 return checksum;
+             }},
+            {"branchless", [](const SearchInput& in, const vector<int32_t>& queries) {
+                 long long checksum = 0;
+                 for (int32_t q : queries)
+                     checksum += branchless_lower_bound(in.keys.data(), in.keys.size(), q);
+                 return checksum;
+             }},
+            {"batched", [](const SearchInput& in, const vector<int32_t>& queries) {
+                 vector<size_t> positions(queries.size());
+                 batch_lower_bound(in.keys.data(), in.keys.size(), queries.data(), queries.size(), positions.data());
+                 long long checksum = 0;
+                 for (size_t pos : positions)
+                     checksum += pos;
+                 return checksum;
+             }},
+            {"eytzinger", [](const SearchInput& in, const vector<int32_t>& queries) {
+                 long long checksum = 0;
+                 for (int32_t q : queries)
+                     checksum += in.eytzinger.lower_bound(q);
+                 return checksum;
+             }},
+            {"interpolation", probe_engine(interpolation_lower_bound<NoProbeCount>)},
+            {"interpolation-sequential", probe_engine(interpolation_sequential_lower_bound<NoProbeCount>)},
+            {"exponential", probe_engine(exponential_lower_bound<NoProbeCount>)},
+        };
+    }
+
+    template <typename Search>
+    static SearchEngine::second_type probe_engine(Search search) {
+        return [search](const SearchInput& in, const vector<int32_t>& queries) {
+            NoProbeCount probe;
+            long long checksum = 0;
+            for (int32_t q : queries)
+                checksum += search(in.keys.data(), in.keys.size(), q, probe);
+            return checksum;
+        };
+    }
+
+    // n records shaped like dataset_generator.py output: 5-letter words and
+    // distinct keys in [1, 2e9] (one per equal slice, so they stay unique),
+    // shuffled, sorted or reversed; few-unique draws every key from 16 values
+    Input generate(size_t n, const string& distribution) {
+        mt19937_64 rng(seed ^ (n * 0x9E3779B97F4A7C15ULL));
+        Input input;
+        input.letters.resize(n * 5);
+        for (char& c : input.letters)
+            c = static_cast<char>('a' + rng() % 26);
+
+        vector<int> keys(n);
+        const double slice = 2e9 / n;
+        for (size_t i = 0; i < n; ++i)
+            keys[i] = 1 + static_cast<int>(i * slice + (rng() % max<uint64_t>(1, static_cast<uint64_t>(slice))));
+        if (distribution == "random")
+            shuffle(keys.begin(), keys.end(), rng);
+        else if (distribution == "reversed")
+            reverse(keys.begin(), keys.end());
+        else if (distribution == "few-unique") {
+            vector<int> values(16);
+            for (int& v : values)
+                v = 1 + static_cast<int>(rng() % 2000000000);
+            for (int& key : keys)
+                key = values[rng() % values.size()];
+        }
+
+        input.rows.resize(n);
+        for (size_t i = 0; i < n; ++i)
+            input.rows[i] = Record(keys[i], string_view(&input.letters[i * 5], 5));
+        return input;
+    }
+
+    // Queries are existing keys picked at random, 10% of n (at least 1000)
+    SearchInput prepare_search(const Input& input) {
+        SearchInput search;
+        search.rows = input.rows;
+        stable_sort(search.rows.begin(), search.rows.end(),
+                    [](const Record& a, const Record& b) { return a.first < b.first; });
+        search.keys = extract_keys(search.rows);
+        search.eytzinger = EytzingerIndex(search.keys);
+
+        mt19937_64 rng(seed + 1);
+        search.queries.resize(max<size_t>(1000, search.rows.size() / 10));
+        for (int32_t& q : search.queries)
+            q = search.keys[rng() % search.keys.size()];
+        return search;
+    }
+
+    BenchmarkResult run_sort(const SortEngine& engine, const Input& input, const string& distribution) {
+        vector<double> times;
+        vector<Record> data;
+        for (size_t run = 0; run < warmup + trials; ++run) {
+            data = input.rows;
+            clobber_memory();
+            auto start_time = high_resolution_clock::now();
+            engine.second(data);
+            clobber_memory();
+            auto end_time = high_resolution_clock::now();
+            do_not_optimize(data.data());
+
+            if (run == 0 && !is_sorted(data.begin(), data.end(),
+                                       [](const Record& a, const Record& b) { return a.first < b.first; }))
+                cerr << "Error: " << engine.first << " did not sort the " << distribution << " input." << endl;
+            if (run >= warmup)
+                times.push_back(duration<double, milli>(end_time - start_time).count());
+        }
+        return report("sort", engine.first, distribution, input.rows.size(), input.rows.size(), times);
+    }
+
+    BenchmarkResult run_search(const SearchEngine& engine, const SearchInput& input, const string& distribution) {
+        vector<double> times;
+        for (size_t run = 0; run < warmup + trials; ++run) {
+            clobber_memory();
+            auto start_time = high_resolution_clock::now();
+            long long checksum = engine.second(input, input.queries);
+            do_not_optimize(checksum);
+            auto end_time = high_resolution_clock::now();
+            if (run >= warmup)
+                times.push_back(duration<double, milli>(end_time - start_time).count());
+        }
+        return report("search", engine.first, distribution, input.rows.size(), input.queries.size(), times);
+    }
+
+    BenchmarkResult report(const string& kind, const string& engine, const string& distribution, size_t n,
+                           size_t operations, const vector<double>& times) {
+        BenchmarkResult result{kind, engine, distribution, n, operations, times.size(), summarize(times)};
+        cout << setw(6) << kind << "  " << setw(24) << left << engine << right << setw(11) << distribution
+             << setw(11) << n << "  median " << setw(10) << result.stats.median << " ms  (min "
+             << result.stats.min << ", p95 " << result.stats.p95 << ", 95% CI " << result.stats.ci_low
+             << " - " << result.stats.ci_high << ")" << endl;
+        return result;
+    }
+
+    bool write_results(const vector<BenchmarkResult>& results, const string& format, const string& filename) {
+        ofstream file(filename);
+        if (!file.is_open())
+            return false;
+        file << fixed << setprecision(6);
+        if (format == "csv") {
+            file << "kind,engine,distribution,size,operations,trials,min_ms,median_ms,p95_ms,mean_ms,ci95_low_ms,ci95_high_ms\n";
+            for (const BenchmarkResult& r : results)
+                file << r.kind << "," << r.engine << "," << r.distribution << "," << r.size << "," << r.operations
+                     << "," << r.trials << "," << r.stats.min << "," << r.stats.median << "," << r.stats.p95 << ","
+                     << r.stats.mean << "," << r.stats.ci_low << "," << r.stats.ci_high << "\n";
+        } else {
+            file << "[\n";
+            for (size_t i = 0; i < results.size(); ++i) {
+                const BenchmarkResult& r = results[i];
+                file << "  {\"kind\": \"" << r.kind << "\", \"engine\": \"" << r.engine << "\", \"distribution\": \""
+                     << r.distribution << "\", \"size\": " << r.size << ", \"operations\": " << r.operations
+                     << ", \"trials\": " << r.trials << ", \"min_ms\": " << r.stats.min << ", \"median_ms\": "
+                     << r.stats.median << ", \"p95_ms\": " << r.stats.p95 << ", \"mean_ms\": " << r.stats.mean
+                     << ", \"ci95_low_ms\": " << r.stats.ci_low << ", \"ci95_high_ms\": " << r.stats.ci_high << "}"
+                     << (i + 1 < results.size() ? "," : "") << "\n";
+            }
+            file << "]\n";
+        }
+        return static_cast<bool>(file);
+    }
+};
+
+int main(int argc, char* argv[]) {
+    Benchmark benchmark;
+    benchmark.main(argc, argv);
+    return 0;
+}
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "csv_loader.hpp"
+
+// Columnar binary dataset (.bin), little-endian, laid out as:
+//
+//   BinaryDatasetHeader                    (64 bytes incl. padding)
+//   int32_t  keys[row_count]               at keys_offset
+//   uint64_t word_offsets[row_count + 1]   at offsets_offset, 8-byte aligned
+//   char     words[blob_size]              at blob_offset
+//
+// Word i is words[word_offsets[i] .. word_offsets[i + 1]), stored exactly as
+// it appeared after the comma in the CSV so sorted output stays byte-identical.
+
+constexpr char kBinaryDatasetMagic[8] = {'A', 'D', 'A', 'D', 'S', 'E', 'T', '1'};
+constexpr uint32_t kBinaryDatasetVersion = 1;
+
+struct BinaryDatasetHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t reserved;
+    uint64_t row_count;
+    uint64_t keys_offset;
+    uint64_t offsets_offset;
+    uint64_t blob_offset;
+    uint64_t blob_size;
+};
+
+constexpr uint64_t kBinaryDatasetHeaderSize = 64;
+static_assert(sizeof(BinaryDatasetHeader) <= kBinaryDatasetHeaderSize, "header must fit its slot");
+
+inline uint64_t align_to_8(uint64_t n) { return (n + 7) & ~uint64_t(7); }
+
+// True if the file name has an extension the tools can load (.csv or .bin)
+inline bool has_dataset_extension(const std::string& filename) {
+    if (filename.size() < 4)
+        return false;
+    std::string ext = filename.substr(filename.size() - 4);
+    return ext == ".csv" || ext == ".bin";
+}
+
+// True if the mapped bytes start with the binary dataset magic
+inline bool is_binary_dataset(const MappedFile& file) {
+    return file.size() >= kBinaryDatasetHeaderSize &&
+           memcmp(file.data(), kBinaryDatasetMagic, sizeof(kBinaryDatasetMagic)) == 0;
+}
+
+// Build rows straight from the mapped columns: no parsing, words stay in the mapping.
+// Returns false if the header or offsets do not describe this file.
+inline bool read_binary_columns(Dataset& dataset) {
+    const char* base = dataset.file.data();
+    const uint64_t size = dataset.file.size();
+
+    BinaryDatasetHeader header;
+    memcpy(&header, base, sizeof(header));
+    if (header.version != kBinaryDatasetVersion)
+        return false;
+
+    const uint64_t n = header.row_count;
+    if (header.keys_offset > size || n > (size - header.keys_offset) / sizeof(int32_t) ||
+        header.offsets_offset % 8 != 0 || header.offsets_offset > size ||
+        n + 1 > (size - header.offsets_offset) / sizeof(uint64_t) ||
+        header.blob_offset > size || header.blob_size > size - header.blob_offset)
+        return false;
+
+    const char* keys = base + header.keys_offset;
+    const uint64_t* offsets = reinterpret_cast<const uint64_t*>(base + header.offsets_offset);
+    const char* blob = base + header.blob_offset;
+    if (offsets[0] != 0 || offsets[n] != header.blob_size)
+        return false;
+
+    dataset.rows.resize(n);
+    for (uint64_t i = 0; i < n; ++i) {
+        if (offsets[i + 1] < offsets[i])
+            return false;
+        int32_t key;
+        memcpy(&key, keys + i * sizeof(int32_t), sizeof(key));
+        dataset.rows[i] = Record(key, std::string_view(blob + offsets[i], offsets[i + 1] - offsets[i]));
+    }
+    return true;
+}
+
+// Load a dataset from either format: .bin files are recognised by their
+// magic bytes and mapped directly, anything else is parsed as CSV.
+// Returns false only if the file cannot be opened.
+template <typename OnBadRow>
+bool load_dataset(const std::string& filename, Dataset& dataset, OnBadRow on_bad_row,
+                  unsigned threads = 0) {
+    dataset.rows.clear();
+    if (!dataset.file.open(filename))
+        return false;
+
+    if (!is_binary_dataset(dataset.file)) {
+        parse_mapped_csv(dataset, on_bad_row, threads);
+        return true;
+    }
+
+    if (!read_binary_columns(dataset)) {
+        std::cerr << "Error: '" << filename << "' is not a valid binary dataset." << std::endl;
+        dataset.rows.clear();
+    }
+    return true;
+}
+
+// Write rows as a binary dataset; returns false if the file cannot be written
+inline bool write_binary_dataset(const std::vector<Record>& rows, const std::string& filename) {
+    std::ofstream out(filename, std::ios::binary);
+    if (!out.is_open())
+        return false;
+
+    const uint64_t n = rows.size();
+    uint64_t blob_size = 0;
+    for (const Record& row : rows)
+        blob_size += row.second.size();
+
+    BinaryDatasetHeader header = {};
+    memcpy(header.magic, kBinaryDatasetMagic, sizeof(header.magic));
+    header.version = kBinaryDatasetVersion;
+    header.row_count = n;
+    header.keys_offset = kBinaryDatasetHeaderSize;
+    header.offsets_offset = align_to_8(header.keys_offset + n * sizeof(int32_t));
+    header.blob_offset = header.offsets_offset + (n + 1) * sizeof(uint64_t);
+    header.blob_size = blob_size;
+
+    char header_slot[kBinaryDatasetHeaderSize] = {};
+    memcpy(header_slot, &header, sizeof(header));
+    out.write(header_slot, sizeof(header_slot));
+
+    std::vector<int32_t> keys(n);
+    for (uint64_t i = 0; i < n; ++i)
+        keys[i] = rows[i].first;
+    out.write(reinterpret_cast<const char*>(keys.data()), n * sizeof(int32_t));
+
+    const char padding[8] = {};
+    out.write(padding, header.offsets_offset - (header.keys_offset + n * sizeof(int32_t)));
+
+    std::vector<uint64_t> offsets(n + 1);
+    offsets[0] = 0;
+    for (uint64_t i = 0; i < n; ++i)
+        offsets[i + 1] = offsets[i] + rows[i].second.size();
+    out.write(reinterpret_cast<const char*>(offsets.data()), (n + 1) * sizeof(uint64_t));
+
+    for (const Record& row : rows)
+        out.write(row.second.data(), row.second.size());
+
+    return static_cast<bool>(out);
+}
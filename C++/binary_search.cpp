@@ -1,80 +1,498 @@
 #include <iostream>
+#include <algorithm>
 #include <fstream>
-#include <sstream>
 #include <vector>
 #include <string>
 #include <chrono>
 #include <iomanip>
 #include <cstdlib>
 #include <ctime>
+#include <memory>
+#include <sstream>
+#include "binary_dataset.hpp"
+#include "cli_options.hpp"
+#include "compact_record.hpp"
+#include "csv_writer.hpp"
+#include "eytzinger_index.hpp"
+#include "key_search.hpp"
+#include "lsm_index.hpp"
+#include "perf_counters.hpp"
+#include "probe_search.hpp"
+#include "query_batch.hpp"
+#include "sort_search.hpp"
 
 using namespace std;
 using namespace std::chrono;
 
-// Function to perform binary search on a vector of pairs
-int binary_search(const vector<pair<int, string>> &data, int target)
+// Function to perform binary search on a vector of pairs (Record or CompactRecord),
+// returning the index of the target or -1; probe() is called for every record
+// read (see probe_search.hpp)
+template <typename Row, typename Probe>
+int binary_search(const vector<Row> &data, int target, Probe &probe)
 {
-    int low = 0;
-    int high = static_cast<int>(data.size()) - 1;
+    auto found = binary_find(data.begin(), data.end(), target, FirstKey(), less<>(), [&probe](auto) { probe(); });
+    return found == data.end() ? -1 : static_cast<int>(found - data.begin());
+}
 
-    while (low <= high)
-    {
-        int mid = (low + high) / 2;
-        int mid_value = data[mid].first; // Get the integer at mid
+// Search engines selectable with --engine
+bool is_known_engine(const string &engine)
+{
+    return engine == "classic" || engine == "branchless" || engine == "batched" || engine == "eytzinger" ||
+           engine == "interpolation" || engine == "interpolation-sequential" || engine == "exponential";
+}
+
+// Engines whose key reads can be counted with the probe harness
+bool counts_probes(const string &engine)
+{
+    return engine == "classic" || engine == "interpolation" || engine == "interpolation-sequential" ||
+           engine == "exponential";
+}
+
+// Everything the engines search; the Eytzinger index is only built when asked for
+struct SearchData
+{
+    const vector<Record> &rows;
+    vector<CompactRecord> compact; // --record=compact: classic searches these instead of rows
+    vector<int32_t> keys;       // Packed key column for the key-only engines
+    EytzingerIndex eytzinger;   // The same keys in BFS order
+    vector<size_t> positions;   // Room for batch results
+};
+
+// Index of the target given its lower_bound position, or -1, like binary_search
+long long found_index(const vector<int32_t> &keys, size_t pos, int target)
+{
+    return (pos < keys.size() && keys[pos] == target) ? static_cast<long long>(pos) : -1;
+}
 
-        if (mid_value == target)
+// Run every target through one of the probe-counting engines:
+//   classic                  - binary_search over the (int, string) records, or the
+//                              16-byte compact records with --record=compact
+//   interpolation            - interpolation search over the packed key column
+//   interpolation-sequential - interpolation down to a few keys, then a linear scan
+//   exponential              - galloping from the front, then bisection
+// Timed with NoProbeCount and measured with ProbeCount, so both see the same code.
+template <typename Probe>
+long long run_probe_searches(const string &engine, SearchData &data, const vector<int> &targets, Probe &probe)
+{
+    const vector<int32_t> &keys = data.keys;
+    long long checksum = 0;
+    if (engine == "interpolation")
+    {
+        for (int target : targets)
+            checksum += found_index(keys, interpolation_lower_bound(keys.data(), keys.size(), target, probe), target);
+    }
+    else if (engine == "interpolation-sequential")
+    {
+        for (int target : targets)
+            checksum += found_index(keys, interpolation_sequential_lower_bound(keys.data(), keys.size(), target, probe), target);
+    }
+    else if (engine == "exponential")
+    {
+        for (int target : targets)
+            checksum += found_index(keys, exponential_lower_bound(keys.data(), keys.size(), target, probe), target);
+    }
+    else
+    {
+        if (!data.compact.empty())
         {
-            return mid;
+            for (int target : targets)
+                checksum += binary_search(data.compact, target, probe);
         }
-        else if (mid_value < target) // If target is greater, search right half
+        else
         {
-            low = mid + 1;
+            for (int target : targets)
+                checksum += binary_search(data.rows, target, probe);
         }
-        else
+    }
+    return checksum;
+}
+
+// Run every target through the selected engine:
+//   branchless - branchless lower_bound over the packed int32 key column
+//   batched    - lockstep batch lower_bound over the key column (AVX2 when available)
+//   eytzinger  - branchless, prefetching descent of the BFS-ordered key index
+//   others     - see run_probe_searches
+// Returns a checksum of the found indices so the searches cannot be optimised away.
+long long run_searches(const string &engine, SearchData &data, const vector<int> &targets)
+{
+    const vector<int32_t> &keys = data.keys;
+    long long checksum = 0;
+    if (engine == "batched")
+    {
+        batch_lower_bound(keys.data(), keys.size(), targets.data(), targets.size(), data.positions.data());
+        for (size_t i = 0; i < targets.size(); ++i)
         {
-            high = mid - 1;  // If target is smaller, search left half
+            size_t pos = data.positions[i];
+            checksum += (pos < keys.size() && keys[pos] == targets[i]) ? static_cast<long long>(pos) : -1;
         }
     }
+    else if (engine == "branchless")
+    {
+        for (int target : targets)
+            checksum += find_key(keys.data(), keys.size(), target);
+    }
+    else if (engine == "eytzinger")
+    {
+        for (int target : targets)
+            checksum += data.eytzinger.find(target);
+    }
+    else
+    {
+        NoProbeCount probe;
+        checksum = run_probe_searches(engine, data, targets, probe);
+    }
+    return checksum;
+}
+
+// Keeps search results observable; written after every timed loop
+volatile long long search_checksum = 0;
 
-    return -1;
+// Time one engine over a target set, in milliseconds
+double time_searches(const string &engine, SearchData &data, const vector<int> &targets)
+{
+    auto start_time = high_resolution_clock::now(); //records the current time using a high-resolution clock. 
+                                                    // It is used to mark the start of a time interval
+    search_checksum = run_searches(engine, data, targets);
+    auto end_time = high_resolution_clock::now();
+    duration<double, milli> elapsed = end_time - start_time;
+    return elapsed.count();
 }
 
-int main()
+// Keys read per lookup, averaged over a target set
+double average_probes(const string &engine, SearchData &data, const vector<int> &targets)
 {
-    srand(static_cast<unsigned int>(time(nullptr))); //seeds the random number generator with the current time. 
+    ProbeCount probe;
+    search_checksum = run_probe_searches(engine, data, targets, probe);
+    return static_cast<double>(probe.probes) / targets.size();
+}
 
-    string sorted_filename; // Variable to hold CSV filename
-    cout << "Enter CSV file name : ";
-    cin >> sorted_filename;
+// Best, average and worst case times of one engine, and its probes per
+// lookup on the random targets
+struct CaseTimes
+{
+    double best_ms = 0;
+    double average_ms = 0;
+    double worst_ms = 0;
+    double average_probes = 0;
+    string counters;   // --perf report for the three cases together
+};
+
+// Size part of a dataset file name ("merge_sort_1000.csv" -> "1000"), or "" if it has none
+string dataset_size_suffix(const string &filename)
+{
+    size_t pos1 = filename.find_last_of("/");
+    string base_name = (pos1 != string::npos) ? filename.substr(pos1 + 1) : filename;
+    size_t pos2 = base_name.find_last_of("_");
+    size_t pos3 = base_name.find_last_of(".");
 
-    vector<pair<int, string>> dataset; // Vector to hold the dataset
-    ifstream file(sorted_filename); // Open the file for reading
+    if (pos2 != string::npos && pos3 != string::npos && pos2 < pos3)
+        return base_name.substr(pos2 + 1, pos3 - pos2 - 1);
+    return "";
+}
+
+// Settings of the --queries batch mode
+struct BatchOptions
+{
+    string queries_filename;
+    string engine = "coscan";   // coscan or parallel; see query_batch.hpp
+    size_t block_size = 4096;   // Queries sorted and answered together
+    unsigned threads = 0;       // Workers for the parallel engine (0 = one per core)
+    bool count_events = false;  // --perf: read hardware counters over the whole run
+};
 
-    if (!file.is_open())
+// The block loop and report shared by both --queries modes. The targets of the
+// query file are answered a block at a time: answer_block(targets, count, rows)
+// sets each row (-1 for a missing target), and word_of(i, row) gives the word of
+// the block's i-th answer. "target,row,word" lines stream to output_filename in
+// query order (an empty word for a missing target). A query's latency is the
+// time its block takes to answer; writing the results is not included. heading
+// is printed first; counters are opened by the caller, before any worker thread.
+template <typename AnswerBlock, typename WordOf>
+int answer_query_blocks(const BatchOptions &options, const string &output_filename, const string &heading,
+                        PerfCounters &counters, AnswerBlock answer_block, WordOf word_of)
+{
+    vector<int32_t> targets;
+    bool opened = load_targets(options.queries_filename, targets, [](size_t, string_view line)
     {
-        cerr << "Error: The file '" << sorted_filename << "' was not found." << endl;
+        cerr << "Skipping invalid line: " << line << endl;
+    });
+    if (!opened)
+    {
+        cerr << "Error: The file '" << options.queries_filename << "' was not found." << endl;
+        return 1;
+    }
+
+    CsvBlockWriter output(output_filename, 8 << 20);
+    if (!output.is_open())
+    {
+        cerr << "Failed to write to " << output_filename << endl;
         return 1;
     }
 
-    string line; // To hold each line from the file
-    while (getline(file, line)) // Read line-by-line
+    vector<long long> rows;
+    vector<pair<double, size_t>> blocks;   // (milliseconds, queries) of every block
+    double answer_ms = 0;
+    size_t found = 0;
+
+    counters.start();
+    auto start_time = high_resolution_clock::now();
+    for (size_t first = 0; first < targets.size(); first += options.block_size)
     {
-        stringstream ss(line); // Create a stream from the line
-        string num_str, word; // Temporary holders for number and string
-        if (getline(ss, num_str, ',') && getline(ss, word)) // Split line at comma
+        size_t count = min(options.block_size, targets.size() - first);
+        rows.resize(count);
+
+        auto block_start = high_resolution_clock::now();
+        answer_block(targets.data() + first, count, rows.data());
+        duration<double, milli> block_time = high_resolution_clock::now() - block_start;
+        blocks.emplace_back(block_time.count(), count);
+        answer_ms += block_time.count();
+
+        for (size_t i = 0; i < count; ++i)
         {
-            try
-            {
-                int number = stoi(num_str); // Convert number string to integer
-                dataset.emplace_back(number, word); // Add parsed pair to dataset
-            }
-            catch (...) // Catch invalid number format
-            {
-                cerr << "Skipping invalid line: " << line << endl;
-            }
+            long long row = rows[i];
+            found += (row >= 0);
+            output.write_answer(targets[first + i], row, row >= 0 ? word_of(i, row) : string_view());
+        }
+    }
+    output.flush();
+    duration<double, milli> total_time = high_resolution_clock::now() - start_time;
+    counters.stop();
+
+    if (!output.good())
+    {
+        cerr << "Failed to write to " << output_filename << endl;
+        return 1;
+    }
+
+    cout << fixed << setprecision(3);
+    cout << heading << endl;
+    cout << "Queries: " << targets.size() << " (" << found << " found)" << endl;
+    cout << "Answer time: " << answer_ms << " ms" << endl;
+    cout << "Throughput: " << (answer_ms > 0 ? targets.size() / (answer_ms / 1000.0) : 0.0) << " queries/s" << endl;
+    cout << "Latency p50: " << latency_percentile(blocks, 50) << " ms, p99: " << latency_percentile(blocks, 99) << " ms" << endl;
+    cout << "Running time: " << total_time.count() << " ms" << endl;   // Answers and output together
+    if (options.count_events)
+        counters.print(cout);
+    cout << "Results written to " << output_filename << endl;
+    return 0;
+}
+
+// Answer every target of the query file against the sorted dataset, sorting and
+// co-scanning each block (see query_batch.hpp), into binary_search_batch_N.csv
+int answer_query_file(const string &sorted_filename, const vector<Record> &dataset, const BatchOptions &options)
+{
+    // Counters opened with inherit only follow threads created after them,
+    // so they are opened before the pool starts its workers
+    PerfCounters counters;
+    if (options.count_events)
+        counters.open();
+
+    vector<int32_t> keys = extract_keys(dataset);
+    unique_ptr<ThreadPool> pool;
+    if (options.engine == "parallel")
+        pool.reset(new ThreadPool(options.threads));
+
+    string size_str = dataset_size_suffix(sorted_filename);
+    string output_filename = size_str.empty() ? "binary_search_batch_result.csv" : "binary_search_batch_" + size_str + ".csv";
+    string heading = "Batch engine: " + options.engine + " (blocks of " + to_string(options.block_size) + " queries)";
+    vector<KeyIndex> sorted;
+    return answer_query_blocks(options, output_filename, heading, counters,
+        [&](const int32_t *targets, size_t count, long long *rows)
+        {
+            sort_queries(targets, count, sorted);
+            if (pool)
+                parallel_queries(*pool, keys.data(), keys.size(), sorted, rows);
+            else
+                coscan_queries(keys.data(), keys.size(), sorted, rows);
+        },
+        [&](size_t, long long row) { return dataset[row].second; });
+}
+
+// Answer the query file against every sorted run in directory (see lsm_index.hpp)
+// without compacting them. The rows and words are those the fully merged file
+// would give, written to binary_search_batch_N.csv with N the total record count
+// of the runs.
+int answer_query_file_lsm(const string &directory, const BatchOptions &options)
+{
+    LsmIndex index;
+    string reason;
+    if (!index.open(directory, [](RowError error, size_t, string_view line)
+    {
+        if (error == RowError::NonInteger)
+            cerr << "Skipping invalid line: " << line << endl;
+    }, reason))
+    {
+        cerr << "Error: " << reason << endl;
+        return 1;
+    }
+    if (index.size() == 0)
+    {
+        cerr << "Error: The dataset is empty." << endl;
+        return 1;
+    }
+
+    PerfCounters counters;
+    if (options.count_events)
+        counters.open();
+
+    string output_filename = "binary_search_batch_" + to_string(index.size()) + ".csv";
+    string heading = "LSM runs: " + to_string(index.run_count()) + " (" + to_string(index.size()) + " records)";
+    vector<string_view> words;
+    return answer_query_blocks(options, output_filename, heading, counters,
+        [&](const int32_t *targets, size_t count, long long *rows)
+        {
+            words.assign(count, string_view());
+            for (size_t i = 0; i < count; ++i)
+                rows[i] = index.find(targets[i], words[i]);
+        },
+        [&](size_t i, long long) { return words[i]; });
+}
+
+// Write every record with lo <= key <= hi to binary_search_range_N.csv in the
+// dataset's own "int,word" format. The matches are a span over the loaded rows,
+// so only the two bound searches run before the records stream out.
+int scan_key_range(const string &sorted_filename, const vector<Record> &dataset, int lo, int hi)
+{
+    string size_str = dataset_size_suffix(sorted_filename);
+    string output_filename = size_str.empty() ? "binary_search_range_result.csv" : "binary_search_range_" + size_str + ".csv";
+    CsvBlockWriter output(output_filename, 8 << 20);
+    if (!output.is_open())
+    {
+        cerr << "Failed to write to " << output_filename << endl;
+        return 1;
+    }
+
+    vector<int32_t> keys = extract_keys(dataset);
+    auto start_time = high_resolution_clock::now();
+    RecordSpan span = key_range(dataset, keys.data(), lo, hi);
+    auto search_end_time = high_resolution_clock::now();
+    for (const Record &record : span)
+        output.write_record(record.first, record.second);
+    output.flush();
+    auto end_time = high_resolution_clock::now();
+
+    if (!output.good())
+    {
+        cerr << "Failed to write to " << output_filename << endl;
+        return 1;
+    }
+
+    duration<double, milli> search_time = search_end_time - start_time;
+    duration<double, milli> total_time = end_time - start_time;
+    cout << fixed << setprecision(3);
+    cout << "Range [" << lo << ", " << hi << "]: " << span.size() << " records";
+    if (!span.empty())
+        cout << " (rows " << (span.begin() - dataset.data()) << " to " << (span.end() - dataset.data() - 1) << ")";
+    cout << endl;
+    cout << "Search time: " << search_time.count() << " ms" << endl;
+    cout << "Running time: " << total_time.count() << " ms" << endl;   // Search and output together
+    cout << "Records written to " << output_filename << endl;
+    return 0;
+}
+
+// Optional arguments:
+//   --engine=NAME   classic (default), branchless, batched, eytzinger, interpolation,
+//                   interpolation-sequential or exponential; see run_searches.
+//                   A comma-separated list (e.g. classic,eytzinger) times each engine
+//                   on the same targets and reports them one after another.
+//   --queries=FILE  answer every target in FILE (CSV lines or a .bin dataset) instead
+//                   of timing the synthetic cases; see answer_query_file
+//   --batch=NAME    coscan (default) or parallel, for --queries
+//   --lsm=DIR       with --queries: answer against the sorted runs merge_sort --lsm
+//                   wrote to DIR, without compacting them (no file name is asked for);
+//                   see answer_query_file_lsm
+//   --batch-size=N  queries per block for --queries (default 4096)
+//   --threads=N     workers for --batch=parallel (default: one per core)
+//   --range=LO,HI   write every record with LO <= key <= HI instead; see scan_key_range
+//   --record=NAME   pair (default) or compact: the classic engine searches 16-byte
+//                   records with the word inline (see compact_record.hpp)
+//   --perf          count cycles, instructions, cache misses and page faults over each
+//                   engine's three timed cases (or the whole --queries run)
+int main(int argc, char *argv[])
+{
+    vector<string> engines = option_list(argc, argv, "engine", "classic");
+    for (const string &engine : engines)
+    {
+        if (!is_known_engine(engine))
+        {
+            cerr << "Error: Unknown search engine '" << engine << "'." << endl;
+            return 1;
+        }
+    }
+
+    BatchOptions batch;
+    batch.queries_filename = option_value(argc, argv, "queries");
+    batch.engine = option_value(argc, argv, "batch", batch.engine);
+    batch.block_size = static_cast<size_t>(max(1L, option_number(argc, argv, "batch-size", 4096)));
+    if (!option_threads(argc, argv, batch.threads))
+    {
+        cerr << "Error: Invalid thread count '" << option_value(argc, argv, "threads") << "'." << endl;
+        return 1;
+    }
+    batch.count_events = has_flag(argc, argv, "perf");
+    if (batch.engine != "coscan" && batch.engine != "parallel")
+    {
+        cerr << "Error: Unknown batch engine '" << batch.engine << "'." << endl;
+        return 1;
+    }
+
+    string record_layout;
+    if (!option_record_layout(argc, argv, record_layout))
+        return 1;
+    bool classic_selected = find(engines.begin(), engines.end(), "classic") != engines.end();
+    if (record_layout == "compact" && (!classic_selected || !batch.queries_filename.empty() ||
+                                       !option_value(argc, argv, "range").empty()))
+    {
+        cerr << "Error: --record=compact only applies to the classic engine's timed searches." << endl;
+        return 1;
+    }
+
+    int range_bounds[2] = {0, 0};
+    string range_option = option_value(argc, argv, "range");
+    if (!range_option.empty())
+    {
+        vector<string> bounds = option_list(argc, argv, "range");
+        if (bounds.size() != 2 || !parse_option_int(bounds[0], range_bounds[0]) ||
+            !parse_option_int(bounds[1], range_bounds[1]))
+        {
+            cerr << "Error: Invalid key range '" << range_option << "', expected LO,HI." << endl;
+            return 1;
+        }
+    }
+
+    string lsm_directory = option_value(argc, argv, "lsm");
+    if (!lsm_directory.empty())
+    {
+        if (batch.queries_filename.empty())
+        {
+            cerr << "Error: --lsm answers a --queries file." << endl;
+            return 1;
+        }
+        return answer_query_file_lsm(lsm_directory, batch);
+    }
+
+    srand(static_cast<unsigned int>(time(nullptr))); //seeds the random number generator with the current time. 
+
+    string sorted_filename; // Variable to hold CSV filename
+    cout << "Enter CSV file name : ";
+    cin >> sorted_filename;
+
+    // Memory-map the CSV or binary dataset file and load it into (int, string) records
+    Dataset loaded;
+    bool opened = load_dataset(sorted_filename, loaded, [](RowError error, size_t, string_view line)
+    {
+        if (error == RowError::NonInteger) // Catch invalid number format
+        {
+            cerr << "Skipping invalid line: " << line << endl;
         }
+    });
+
+    if (!opened)
+    {
+        cerr << "Error: The file '" << sorted_filename << "' was not found." << endl;
+        return 1;
     }
-    file.close();
+    const vector<Record> &dataset = loaded.rows;
 
     int n = static_cast<int>(dataset.size());
     if (n == 0)
@@ -83,68 +501,106 @@ int main()
         return 1;
     }
 
-    // --- Best Case Analysis ---
-    int best_case_target = dataset[(n / 2) - 1].first;
-    auto start_time = high_resolution_clock::now(); //records the current time using a high-resolution clock. 
-                                                    // It is used to mark the start of a time interval
-    for (int i = 0; i < n; ++i) //This loop repeatedly calls the binary_search function n times, 
-                                // each time searching for the best_case_target in the dataset.
+    if (!batch.queries_filename.empty())
+        return answer_query_file(sorted_filename, dataset, batch);
+    if (!range_option.empty())
+        return scan_key_range(sorted_filename, dataset, range_bounds[0], range_bounds[1]);
+
+    // Packed key column for the key-only engines, plus the Eytzinger index if requested
+    SearchData data{dataset, vector<CompactRecord>(), extract_keys(dataset), EytzingerIndex(), vector<size_t>(n)};
+    if (record_layout == "compact" && classic_selected && !compact_rows(dataset, data.compact))
     {
-        binary_search(dataset, best_case_target);
+        cerr << "Error: A word in " << sorted_filename << " is too long for compact records." << endl;
+        return 1;
     }
-    auto end_time = high_resolution_clock::now();
-    duration<double, milli> best_case_time = end_time - start_time;
+    duration<double, milli> index_build_time(0);
+    if (find(engines.begin(), engines.end(), "eytzinger") != engines.end())
+    {
+        auto start_time = high_resolution_clock::now();
+        data.eytzinger = EytzingerIndex(data.keys);
+        index_build_time = high_resolution_clock::now() - start_time;
+    }
+
+    // --- Best Case Analysis ---
+    int best_case_target = dataset[(n / 2) - 1].first;
+    vector<int> best_case_targets(n, best_case_target); // The same target searched n times
 
     // --- Worst Case Analysis ---
     int worst_case_target = -1;
-    start_time = high_resolution_clock::now();
-    for (int i = 0; i < n; ++i)
-    {
-        binary_search(dataset, worst_case_target);
-    }
-    end_time = high_resolution_clock::now();
-    duration<double, milli> worst_case_time = end_time - start_time;
+    vector<int> worst_case_targets(n, worst_case_target);
 
     // --- Average Case Analysis (sample 10% random targets) ---
     int sample_size = n / 10;
     if (sample_size == 0)
         sample_size = 1; // ensure at least one sample
 
-    start_time = high_resolution_clock::now();
-    for (int i = 0; i < sample_size; ++i) //It runs binary_search sample_size times, 
-                                          // each time searching for a randomly selected target from the dataset.
+    vector<int> random_targets(sample_size); // Each one a randomly selected key from the dataset
+    for (int i = 0; i < sample_size; ++i)
     {
         int random_index = rand() % n;
-        int random_target = dataset[random_index].first;
-        binary_search(dataset, random_target);
+        random_targets[i] = dataset[random_index].first;
+    }
+
+    // Every engine searches the same targets, so the reports are comparable
+    PerfCounters counters;
+    if (batch.count_events)
+        counters.open();
+    vector<CaseTimes> times(engines.size());
+    for (size_t e = 0; e < engines.size(); ++e)
+    {
+        counters.start();
+        times[e].best_ms = time_searches(engines[e], data, best_case_targets);
+        times[e].worst_ms = time_searches(engines[e], data, worst_case_targets);
+        times[e].average_ms = time_searches(engines[e], data, random_targets);
+        counters.stop();
+        if (batch.count_events)
+        {
+            ostringstream report;
+            counters.print(report);
+            times[e].counters = report.str();
+        }
+        if (counts_probes(engines[e]))
+            times[e].average_probes = average_probes(engines[e], data, random_targets);
     }
-    end_time = high_resolution_clock::now();
-    duration<double, milli> average_case_time = end_time - start_time;
 
     // --- Output Results to File ---
     string output_filename = "binary_search_result.txt";
-    size_t pos1 = sorted_filename.find_last_of("/");
-    string base_name = (pos1 != string::npos) ? sorted_filename.substr(pos1 + 1) : sorted_filename;
-    size_t pos2 = base_name.find_last_of("_");
-    size_t pos3 = base_name.find_last_of(".");
-
-    if (pos2 != string::npos && pos3 != string::npos && pos2 < pos3)
-    {
-        string size_str = base_name.substr(pos2 + 1, pos3 - pos2 - 1);
+    string size_str = dataset_size_suffix(sorted_filename);
+    if (!size_str.empty())
         output_filename = "binary_search_" + size_str + ".txt";
-    }
 
     ofstream output_file(output_filename);
     if (output_file.is_open())
     {
         output_file << fixed << setprecision(3);
-        output_file << "Best case target: " << best_case_target << "\n";
-        output_file << "Best case time: " << best_case_time.count() << " ms\n\n";
+        for (size_t e = 0; e < engines.size(); ++e)
+        {
+            const string &engine = engines[e];
+            if (e > 0)
+                output_file << "\n";
+            if (engines.size() > 1 || engine != "classic")
+            {
+                output_file << "Search engine: " << engine;
+                if (engine == "batched")
+                    output_file << (batch_search_uses_avx2(data.keys.size()) ? " (AVX2)" : " (scalar)");
+                output_file << "\n";
+                if (engine == "eytzinger")
+                    output_file << "Index build time: " << index_build_time.count() << " ms\n";
+                output_file << "\n";
+            }
+            output_file << "Best case target: " << best_case_target << "\n";
+            output_file << "Best case time: " << times[e].best_ms << " ms\n\n";
 
-        output_file << "Average case time (10% random targets): " << average_case_time.count() << " ms\n\n";
+            output_file << "Average case time (10% random targets): " << times[e].average_ms << " ms\n";
+            if (counts_probes(engine))
+                output_file << "Average probes per lookup: " << times[e].average_probes << "\n";
+            output_file << "\n";
 
-        output_file << "Worst case target: " << worst_case_target << "\n";
-        output_file << "Worst case time: " << worst_case_time.count() << " ms\n";
+            output_file << "Worst case target: " << worst_case_target << "\n";
+            output_file << "Worst case time: " << times[e].worst_ms << " ms\n";
+            if (!times[e].counters.empty())
+                output_file << "\n" << times[e].counters;
+        }
 
         output_file.close();
         cout << "Timing analysis with targets has been written to '" << output_filename << "'." << endl;
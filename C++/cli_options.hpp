@@ -0,0 +1,92 @@
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+// Tools still ask for the file name on stdin; optional tuning knobs are
+// passed as "--name=value" or "--flag" command-line arguments.
+
+// Value of "--name=value", or `fallback` if the option was not given
+inline std::string option_value(int argc, char* argv[], const std::string& name,
+                                const std::string& fallback = "") {
+    const std::string prefix = "--" + name + "=";
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.compare(0, prefix.size(), prefix) == 0)
+            return arg.substr(prefix.size());
+    }
+    return fallback;
+}
+
+// Numeric value of "--name=N", or `fallback` if missing or not a number
+inline long option_number(int argc, char* argv[], const std::string& name, long fallback) {
+    std::string value = option_value(argc, argv, name);
+    if (value.empty())
+        return fallback;
+    char* end = nullptr;
+    long number = std::strtol(value.c_str(), &end, 10);
+    return (end && *end == '\0') ? number : fallback;
+}
+
+// One int option value, such as an item of option_list: an optional sign and
+// digits, with nothing before or after them. False if text is anything else
+// or does not fit an int.
+inline bool parse_option_int(const std::string& text, int& value) {
+    size_t digits = (!text.empty() && (text[0] == '+' || text[0] == '-')) ? 1 : 0;
+    if (digits == text.size() || text[digits] < '0' || text[digits] > '9')
+        return false;
+    errno = 0;
+    char* end = nullptr;
+    long number = std::strtol(text.c_str(), &end, 10);
+    if (*end != '\0' || errno == ERANGE || number < INT_MIN || number > INT_MAX)
+        return false;
+    value = static_cast<int>(number);
+    return true;
+}
+
+// Most worker threads any tool starts for --threads
+constexpr long kMaxThreadsOption = 1024;
+
+// "--threads=N" as a thread count, 0 (one per core) if not given. Returns
+// false for a negative or non-numeric N; larger counts are clamped to
+// kMaxThreadsOption.
+inline bool option_threads(int argc, char* argv[], unsigned& threads) {
+    threads = 0;
+    std::string value = option_value(argc, argv, "threads");
+    if (value.empty())
+        return true;
+    char* end = nullptr;
+    long number = std::strtol(value.c_str(), &end, 10);
+    if (!end || *end != '\0' || number < 0)
+        return false;
+    threads = static_cast<unsigned>(std::min(number, kMaxThreadsOption));
+    return true;
+}
+
+// Comma-separated values of "--name=a,b,c", or `fallback` as the only item
+inline std::vector<std::string> option_list(int argc, char* argv[], const std::string& name,
+                                            const std::string& fallback = "") {
+    std::string value = option_value(argc, argv, name, fallback);
+    std::vector<std::string> items;
+    size_t start = 0;
+    for (;;) {
+        size_t comma = value.find(',', start);
+        items.push_back(value.substr(start, comma - start));
+        if (comma == std::string::npos)
+            return items;
+        start = comma + 1;
+    }
+}
+
+// True if "--name" was given
+inline bool has_flag(int argc, char* argv[], const std::string& name) {
+    const std::string flag = "--" + name;
+    for (int i = 1; i < argc; ++i)
+        if (flag == argv[i])
+            return true;
+    return false;
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include "cli_options.hpp"
+#include "csv_loader.hpp"
+
+// A 16-byte, trivially copyable alternative to Record for the sort kernels.
+// The generated datasets hold 5-letter words (plus a '\r' in CRLF files), so
+// the word is normally copied into the record itself: moving a record is one
+// 16-byte copy and a sorted array touches no memory outside itself. A word
+// longer than kInlineWordBytes stays in the mapped file; the record keeps a
+// pointer to it and a 24-bit length instead, so any dataset still loads.
+//
+// Layout: key (4) | length or kLongWord (1) | 11 bytes of word, or for a
+// long word 3 bytes of length and the 8-byte pointer.
+struct CompactRecord {
+    static constexpr size_t kInlineWordBytes = 11;
+    static constexpr uint8_t kLongWord = 0xFF;
+    static constexpr size_t kMaxLongWordBytes = (1u << 24) - 1;
+
+    int first;   // The key, named like Record's so the .first-ordered kernels take both
+    uint8_t length;
+    char bytes[kInlineWordBytes];
+
+    CompactRecord() = default;
+
+    // word must outlive the record if it is longer than kInlineWordBytes
+    CompactRecord(int key, std::string_view word) : first(key) {
+        if (word.size() <= kInlineWordBytes) {
+            length = static_cast<uint8_t>(word.size());
+            memcpy(bytes, word.data(), word.size());
+            memset(bytes + word.size(), 0, kInlineWordBytes - word.size());
+        } else {
+            length = kLongWord;
+            uint32_t size = static_cast<uint32_t>(word.size());
+            memcpy(bytes, &size, 3);   // Little-endian low 3 bytes
+            const char* data = word.data();
+            memcpy(bytes + 3, &data, sizeof(data));
+        }
+    }
+
+    bool is_inline() const { return length != kLongWord; }
+
+    std::string_view word() const {
+        if (is_inline())
+            return std::string_view(bytes, length);
+        uint32_t size = 0;
+        memcpy(&size, bytes, 3);
+        const char* data;
+        memcpy(&data, bytes + 3, sizeof(data));
+        return std::string_view(data, size);
+    }
+};
+
+static_assert(sizeof(CompactRecord) == 16, "CompactRecord must stay 16 bytes");
+static_assert(std::is_trivially_copyable<CompactRecord>::value, "CompactRecord must be memcpy-able");
+
+// The word of either record type, for code written once for both
+inline std::string_view record_word(const Record& record) { return record.second; }
+inline std::string_view record_word(const CompactRecord& record) { return record.word(); }
+
+// Copy loaded rows into compact records, in the same order. Long words still
+// point into the dataset's mapping, so `rows`' Dataset must outlive the result.
+// Returns false (and leaves compact empty) if a word is too long to point to.
+inline bool compact_rows(const std::vector<Record>& rows, std::vector<CompactRecord>& compact) {
+    compact.clear();
+    compact.reserve(rows.size());
+    for (const Record& row : rows) {
+        if (row.second.size() > CompactRecord::kMaxLongWordBytes) {
+            compact.clear();
+            return false;
+        }
+        compact.emplace_back(row.first, row.second);
+    }
+    return true;
+}
+
+// Number of records whose word is stored inline
+inline size_t count_inline_words(const std::vector<CompactRecord>& compact) {
+    size_t count = 0;
+    for (const CompactRecord& record : compact)
+        count += record.is_inline();
+    return count;
+}
+
+// "--record=pair|compact" (default pair); false, after an error, for any other layout
+inline bool option_record_layout(int argc, char* argv[], std::string& layout) {
+    layout = option_value(argc, argv, "record", "pair");
+    if (layout != "pair" && layout != "compact") {
+        std::cerr << "Error: Unknown record layout '" << layout << "'." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// --record=compact in the sort tools: copy the loaded rows of filename into
+// compact records, free the pair rows and report how many words went inline.
+// Long words still point into the mapping, which must stay open. False,
+// after an error, if a word is too long to point to.
+inline bool compact_loaded_rows(std::vector<Record>& rows, std::vector<CompactRecord>& compact,
+                                const std::string& filename) {
+    if (!compact_rows(rows, compact)) {
+        std::cerr << "Error: A word in '" << filename << "' is too long for compact records." << std::endl;
+        return false;
+    }
+    std::vector<Record>().swap(rows);
+    std::cout << "Compact records: " << count_inline_words(compact) << " of " << compact.size() << " words inline"
+              << std::endl;
+    return true;
+}
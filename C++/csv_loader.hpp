@@ -0,0 +1,293 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// One dataset row: the integer key and a view of the word in the mapped file
+using Record = std::pair<int, std::string_view>;
+
+// Why a row was rejected by the loader
+enum class RowError {
+    Malformed,   // no comma, or nothing after the comma
+    NonInteger   // first column is not a valid int
+};
+
+// Read-only memory mapping of a whole file, released on destruction
+class MappedFile {
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    MappedFile(MappedFile&& other) noexcept
+        : data_(other.data_), size_(other.size_) {
+        other.data_ = nullptr;
+        other.size_ = 0;
+    }
+
+    MappedFile& operator=(MappedFile&& other) noexcept {
+        if (this != &other) {
+            unmap();
+            data_ = other.data_;
+            size_ = other.size_;
+            other.data_ = nullptr;
+            other.size_ = 0;
+        }
+        return *this;
+    }
+
+    ~MappedFile() { unmap(); }
+
+    // Map the file; returns false if it cannot be opened or mapped
+    bool open(const std::string& filename) {
+        unmap();
+        int fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd < 0)
+            return false;
+
+        struct stat st;
+        if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+            ::close(fd);
+            return false;
+        }
+
+        size_ = static_cast<size_t>(st.st_size);
+        if (size_ > 0) {  // mmap rejects zero-length mappings; an empty file is simply empty
+            void* p = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p == MAP_FAILED) {
+                ::close(fd);
+                size_ = 0;
+                return false;
+            }
+            data_ = static_cast<const char*>(p);
+            madvise(p, size_, MADV_SEQUENTIAL);  // We scan front to back exactly once
+        }
+        ::close(fd);  // The mapping stays valid after the descriptor is closed
+        return true;
+    }
+
+    const char* data() const { return data_; }
+    size_t size() const { return size_; }
+
+private:
+    void unmap() {
+        if (data_)
+            munmap(const_cast<char*>(data_), size_);
+        data_ = nullptr;
+        size_ = 0;
+    }
+
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+// Parse a decimal int from [first, last) with the same rules as std::stoi:
+// leading whitespace and a sign are allowed, at least one digit is required,
+// anything after the digits is ignored, and values outside int are rejected.
+inline bool parse_int(const char* first, const char* last, int& value) {
+    while (first != last && (*first == ' ' || (*first >= '\t' && *first <= '\r')))
+        ++first;
+
+    bool negative = false;
+    if (first != last && (*first == '+' || *first == '-')) {
+        negative = (*first == '-');
+        ++first;
+    }
+
+    const char* digits = first;
+    int64_t acc = 0;
+    const int64_t limit = negative ? -static_cast<int64_t>(INT32_MIN) : INT32_MAX;
+    while (first != last && static_cast<unsigned>(*first - '0') < 10) {
+        acc = acc * 10 + (*first - '0');
+        if (acc > limit)
+            return false;  // Out of range, like stoi throwing out_of_range
+        ++first;
+    }
+    if (first == digits)
+        return false;      // No digits, like stoi throwing invalid_argument
+
+    value = static_cast<int>(negative ? -acc : acc);
+    return true;
+}
+
+// Rows loaded from a dataset file; the string views point into `file`,
+// so the rows are only valid while this object is alive.
+struct Dataset {
+    MappedFile file;
+    std::vector<Record> rows;
+};
+
+// Parse one line of "int,word" (line excludes the '\n'), matching the old
+// getline(ss, num, ',') && getline(ss, word) split: the word is everything
+// after the first comma, including any '\r', and must not be empty.
+template <typename OnBadRow>
+inline void parse_csv_line(const char* line, const char* line_end, size_t row_num,
+                           std::vector<Record>& rows, OnBadRow& on_bad_row) {
+    const char* comma = static_cast<const char*>(memchr(line, ',', line_end - line));
+    if (!comma || comma + 1 == line_end) {
+        on_bad_row(RowError::Malformed, row_num, std::string_view(line, line_end - line));
+        return;
+    }
+
+    int number;
+    if (!parse_int(line, comma, number)) {
+        on_bad_row(RowError::NonInteger, row_num, std::string_view(line, line_end - line));
+        return;
+    }
+    rows.emplace_back(number, std::string_view(comma + 1, line_end - comma - 1));
+}
+
+// Count lines in [first, last), including a final line without '\n'
+inline size_t count_lines(const char* first, const char* last) {
+    size_t lines = 0;
+    while (first < last) {
+        const char* nl = static_cast<const char*>(memchr(first, '\n', last - first));
+        ++lines;
+        if (!nl)
+            break;
+        first = nl + 1;
+    }
+    return lines;
+}
+
+// A rejected line remembered by a parser thread until it can be reported in order
+struct BadRow {
+    RowError error;
+    size_t line_in_chunk;  // 1-based line number within the chunk
+    std::string_view line;
+};
+
+// Output of one parser thread for its slice of the file
+struct CsvChunk {
+    std::vector<Record> rows;
+    std::vector<BadRow> bad_rows;
+    size_t lines = 0;
+};
+
+// Parse every line in [first, last) into `chunk`, deferring warnings
+inline void parse_csv_chunk(const char* first, const char* last, CsvChunk& chunk) {
+    chunk.rows.reserve(count_lines(first, last));
+    auto remember = [&chunk](RowError error, size_t line_in_chunk, std::string_view line) {
+        chunk.bad_rows.push_back({error, line_in_chunk, line});
+    };
+    while (first < last) {
+        const char* nl = static_cast<const char*>(memchr(first, '\n', last - first));
+        const char* line_end = nl ? nl : last;
+        parse_csv_line(first, line_end, ++chunk.lines, chunk.rows, remember);
+        first = line_end + 1;
+    }
+}
+
+// Files smaller than this per thread are not worth splitting
+constexpr size_t kMinBytesPerIngestThread = 4 << 20;
+
+// Number of parser threads for a file of `size` bytes; `requested` 0 means all cores
+inline unsigned ingest_thread_count(size_t size, unsigned requested) {
+    unsigned threads = requested ? requested : std::thread::hardware_concurrency();
+    if (threads == 0)
+        threads = 1;
+    size_t useful = size / kMinBytesPerIngestThread;
+    if (requested == 0 && useful < threads)
+        threads = static_cast<unsigned>(useful ? useful : 1);
+    return threads;
+}
+
+// Split the mapping into `threads` newline-aligned chunks, parse them
+// concurrently, then report warnings and splice rows in file order.
+template <typename OnBadRow>
+void load_csv_chunked(Dataset& dataset, unsigned threads, OnBadRow& on_bad_row) {
+    const char* begin = dataset.file.data();
+    const char* end = begin + dataset.file.size();
+
+    // Chunk i covers [bounds[i], bounds[i + 1]); every inner bound starts a line
+    std::vector<const char*> bounds(threads + 1, end);
+    bounds[0] = begin;
+    for (unsigned i = 1; i < threads; ++i) {
+        const char* guess = begin + dataset.file.size() / threads * i;
+        if (guess < bounds[i - 1])
+            guess = bounds[i - 1];
+        const char* nl = static_cast<const char*>(memchr(guess, '\n', end - guess));
+        bounds[i] = nl ? nl + 1 : end;
+    }
+
+    std::vector<CsvChunk> chunks(threads);
+    std::vector<std::thread> workers;
+    for (unsigned i = 0; i < threads; ++i)
+        workers.emplace_back(parse_csv_chunk, bounds[i], bounds[i + 1], std::ref(chunks[i]));
+    for (auto& worker : workers)
+        worker.join();
+
+    // Warnings go out in file order with file-wide row numbers
+    std::vector<size_t> row_offset(threads + 1, 0);
+    size_t lines_before = 0;
+    for (unsigned i = 0; i < threads; ++i) {
+        for (const BadRow& bad : chunks[i].bad_rows)
+            on_bad_row(bad.error, lines_before + bad.line_in_chunk, bad.line);
+        lines_before += chunks[i].lines;
+        row_offset[i + 1] = row_offset[i] + chunks[i].rows.size();
+    }
+
+    // Splice the thread-local vectors into place, one copy per thread
+    dataset.rows.resize(row_offset[threads]);
+    workers.clear();
+    for (unsigned i = 0; i < threads; ++i) {
+        workers.emplace_back([&dataset, &chunks, &row_offset, i]() {
+            std::copy(chunks[i].rows.begin(), chunks[i].rows.end(), dataset.rows.begin() + row_offset[i]);
+            std::vector<Record>().swap(chunks[i].rows);
+        });
+    }
+    for (auto& worker : workers)
+        worker.join();
+}
+
+// Parse the CSV text already mapped in `dataset.file` into `dataset.rows`.
+// on_bad_row(RowError, row_num, line) is called for every rejected line
+// (row_num is 1-based) so each tool can keep its own warning wording.
+// Large files are parsed on `threads` cores (0 = one per core, 1 = serial).
+template <typename OnBadRow>
+void parse_mapped_csv(Dataset& dataset, OnBadRow& on_bad_row, unsigned threads) {
+    if (dataset.file.size() == 0)
+        return;   // An empty file maps to no memory at all, so there is nothing to split or scan
+    threads = ingest_thread_count(dataset.file.size(), threads);
+    if (threads > 1) {
+        load_csv_chunked(dataset, threads, on_bad_row);
+        return;
+    }
+
+    const char* p = dataset.file.data();
+    const char* end = p + dataset.file.size();
+    dataset.rows.reserve(count_lines(p, end));
+
+    size_t row_num = 0;
+    while (p < end) {
+        const char* nl = static_cast<const char*>(memchr(p, '\n', end - p));
+        const char* line_end = nl ? nl : end;
+        parse_csv_line(p, line_end, ++row_num, dataset.rows, on_bad_row);
+        p = line_end + 1;
+    }
+}
+
+// Load "int,word" rows from a CSV file without copying the text.
+// Returns false only if the file cannot be opened.
+template <typename OnBadRow>
+bool load_csv(const std::string& filename, Dataset& dataset, OnBadRow on_bad_row,
+              unsigned threads = 0) {
+    dataset.rows.clear();
+    if (!dataset.file.open(filename))
+        return false;
+    parse_mapped_csv(dataset, on_bad_row, threads);
+    return true;
+}
@@ -0,0 +1,76 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <iomanip>
+#include "cli_options.hpp"
+#include "binary_dataset.hpp"
+
+using namespace std;
+using namespace std::chrono;
+
+// Converts a dataset CSV into the columnar binary format (see binary_dataset.hpp)
+// so the sort and search tools can map it directly instead of re-parsing text.
+class CsvToBinary {
+public:
+    // Optional arguments:
+    //   --threads=N   CSV parser threads (default: one per core for large files, 1 = serial)
+    void main(int argc, char* argv[]) {
+        unsigned ingest_threads;
+        if (!option_threads(argc, argv, ingest_threads)) {
+            cerr << "Error: Invalid thread count '" << option_value(argc, argv, "threads") << "'." << endl;
+            return;
+        }
+
+        string input_filename;
+        cout << "Enter CSV file name: ";  // Ask user to enter CSV file name
+        cin >> input_filename;
+
+        // Check if file name ends with ".csv"
+        if (input_filename.size() < 4 || input_filename.substr(input_filename.size() - 4) != ".csv") {
+            cerr << "Error: Please provide a valid CSV file." << endl;
+            return;
+        }
+
+        // Parse the CSV file into (int, string) records
+        Dataset dataset;
+        bool opened = load_csv(input_filename, dataset, [](RowError error, size_t row_num, string_view line) {
+            if (error == RowError::NonInteger)
+                cerr << "Skipping row " << row_num << " due to non-integer value: " << line << endl;
+            else
+                cerr << "Skipping row " << row_num << " due to malformed row: " << line << endl;
+        }, ingest_threads);
+
+        if (!opened) {
+            cerr << "Error: File '" << input_filename << "' not found." << endl;
+            return;
+        }
+        if (dataset.rows.empty()) {
+            cerr << "Error: Could not read data from " << input_filename << endl;
+            return;
+        }
+
+        // dataset_N.csv becomes dataset_N.bin next to it
+        string output_filename = input_filename.substr(0, input_filename.size() - 4) + ".bin";
+
+        auto start_time = high_resolution_clock::now();
+        bool written = write_binary_dataset(dataset.rows, output_filename);
+        auto end_time = high_resolution_clock::now();
+
+        if (!written) {
+            cerr << "An error occurred while writing the binary dataset: " << output_filename << endl;
+            return;
+        }
+
+        duration<double, milli> duration = end_time - start_time;
+        cout << fixed << setprecision(3);
+        cout << "Running time: " << duration.count() << " ms" << endl;
+        cout << dataset.rows.size() << " records written to " << output_filename << endl;
+    }
+};
+
+int main(int argc, char* argv[]) {
+    CsvToBinary converter;
+    converter.main(argc, argv);
+    return 0;
+}
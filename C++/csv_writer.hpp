@@ -0,0 +1,176 @@
+#pragma once
+
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+// "00" "01" ... "99": two digits per table lookup instead of one division each
+inline constexpr char kDigitPairs[201] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+// Longest decimal long long, sign included
+constexpr size_t kMaxDecimalDigits = 20;
+
+// Write value in decimal at out (same text as ostream << or to_chars) and
+// return the end; out needs room for kMaxDecimalDigits chars
+inline char* format_decimal(char* out, long long value) {
+    unsigned long long magnitude = static_cast<unsigned long long>(value);
+    if (value < 0) {
+        *out++ = '-';
+        magnitude = 0 - magnitude;
+    }
+    char digits[kMaxDecimalDigits];
+    char* p = digits + kMaxDecimalDigits;
+    while (magnitude >= 100) {
+        p -= 2;
+        memcpy(p, kDigitPairs + 2 * (magnitude % 100), 2);
+        magnitude /= 100;
+    }
+    if (magnitude >= 10) {
+        p -= 2;
+        memcpy(p, kDigitPairs + 2 * magnitude, 2);
+    } else {
+        *--p = static_cast<char>('0' + magnitude);
+    }
+    size_t length = digits + kMaxDecimalDigits - p;
+    memcpy(out, p, length);
+    return out + length;
+}
+
+// Copy text to out and return the end. An empty view may have a null data(),
+// which memcpy must not be given even for zero bytes.
+inline char* append_text(char* out, std::string_view text) {
+    if (!text.empty())
+        memcpy(out, text.data(), text.size());
+    return out + text.size();
+}
+
+// Appends "key,word\n" lines to a file through one large buffer, handed to
+// write() whole when it fills. With background set, a full buffer is written
+// on a second thread while the caller formats the next one into a spare, so
+// formatting and I/O overlap; flush() waits for both.
+class CsvBlockWriter {
+public:
+    CsvBlockWriter(const std::string& filename, size_t buffer_bytes, bool background = false)
+        : fd_(::open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644)),
+          capacity_(buffer_bytes < 4096 ? 4096 : buffer_bytes),
+          buffer_(new char[capacity_]),
+          background_(background) {
+        if (background_)
+            spare_.reset(new char[capacity_]);
+    }
+
+    ~CsvBlockWriter() {
+        flush();
+        if (fd_ >= 0)
+            close(fd_);
+    }
+
+    CsvBlockWriter(const CsvBlockWriter&) = delete;
+    CsvBlockWriter& operator=(const CsvBlockWriter&) = delete;
+
+    bool is_open() const { return fd_ >= 0; }
+    bool good() const { return fd_ >= 0 && !failed_; }
+
+    void write_line(std::string_view line) {
+        append_text(reserve(line.size()), line);
+        used_ += line.size();
+    }
+
+    void write_record(int key, std::string_view word) {
+        char* out = reserve(kMaxDecimalDigits + word.size() + 2);
+        out = format_decimal(out, key);
+        *out++ = ',';
+        out = append_text(out, word);
+        *out++ = '\n';
+        used_ = out - buffer_.get();
+    }
+
+    // "target,row,word\n" for one answered query
+    void write_answer(int target, long long row, std::string_view word) {
+        char* out = reserve(2 * kMaxDecimalDigits + word.size() + 3);
+        out = format_decimal(out, target);
+        *out++ = ',';
+        out = format_decimal(out, row);
+        *out++ = ',';
+        out = append_text(out, word);
+        *out++ = '\n';
+        used_ = out - buffer_.get();
+    }
+
+    // Write out everything buffered so far, including a background block
+    void flush() {
+        submit();
+        wait();
+    }
+
+private:
+    int fd_;
+    size_t capacity_;
+    size_t used_ = 0;
+    std::unique_ptr<char[]> buffer_;
+    std::unique_ptr<char[]> spare_;   // Background mode: the block being written
+    bool background_;
+    bool failed_ = false;
+    std::thread writer_;
+
+    // Room for length more bytes; a line longer than the buffer grows it
+    char* reserve(size_t length) {
+        if (used_ + length > capacity_)
+            submit();
+        if (length > capacity_) {
+            wait();
+            capacity_ = length;
+            buffer_.reset(new char[capacity_]);
+            if (background_)
+                spare_.reset(new char[capacity_]);
+        }
+        return buffer_.get() + used_;
+    }
+
+    // Hand the buffered bytes to write(), on the writer thread in background mode
+    void submit() {
+        if (used_ == 0)
+            return;
+        if (!background_) {
+            write_block(buffer_.get(), used_);
+            used_ = 0;
+            return;
+        }
+        wait();
+        buffer_.swap(spare_);
+        writer_ = std::thread([this, size = used_]() { write_block(spare_.get(), size); });
+        used_ = 0;
+    }
+
+    void wait() {
+        if (writer_.joinable())
+            writer_.join();
+    }
+
+    // write() may take less than asked for, so loop until the block is out
+    void write_block(const char* data, size_t size) {
+        if (fd_ < 0 || failed_)
+            return;
+        while (size > 0) {
+            ssize_t written = ::write(fd_, data, size);
+            if (written < 0 && errno == EINTR)
+                continue;
+            if (written <= 0) {
+                failed_ = true;
+                return;
+            }
+            data += written;
+            size -= static_cast<size_t>(written);
+        }
+    }
+};
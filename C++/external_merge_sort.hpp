@@ -0,0 +1,277 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "csv_loader.hpp"
+#include "csv_writer.hpp"
+
+// Reads a sorted run back one line at a time through a large buffer.
+// Lines are "key,word\n" exactly as the run was written; a last line without
+// its '\n' (a CSV written by another tool) is given one.
+class RunReader {
+public:
+    RunReader(const std::string& filename, size_t buffer_bytes)
+        : fd_(::open(filename.c_str(), O_RDONLY)), buffer_(buffer_bytes < 4096 ? 4096 : buffer_bytes) {}
+
+    ~RunReader() {
+        if (fd_ >= 0)
+            ::close(fd_);
+    }
+
+    bool is_open() const { return fd_ >= 0; }
+
+    // Advance to the next line; false once the run is exhausted
+    bool next() {
+        for (;;) {
+            const char* nl = static_cast<const char*>(memchr(buffer_.data() + pos_, '\n', end_ - pos_));
+            if (nl) {
+                size_t length = nl + 1 - (buffer_.data() + pos_);
+                line_ = std::string_view(buffer_.data() + pos_, length);
+                pos_ += length;
+                has_key_ = parse_int(line_.data(), line_.data() + line_.size(), key_);
+                return true;
+            }
+            if (!refill()) {
+                if (pos_ == end_)
+                    return false;
+                if (end_ == buffer_.size())
+                    buffer_.resize(buffer_.size() + 1);
+                buffer_[end_++] = '\n';   // Terminate the unterminated last line
+            }
+        }
+    }
+
+    int key() const { return key_; }
+    bool has_key() const { return has_key_; }   // False if the line does not start with an int
+    std::string_view line() const { return line_; }   // Includes the '\n'
+
+private:
+    // Keep the partial line, then read more after it; grows for very long lines
+    bool refill() {
+        size_t leftover = end_ - pos_;
+        memmove(buffer_.data(), buffer_.data() + pos_, leftover);
+        pos_ = 0;
+        end_ = leftover;
+        if (end_ == buffer_.size())
+            buffer_.resize(buffer_.size() * 2);
+        ssize_t got = ::read(fd_, buffer_.data() + end_, buffer_.size() - end_);
+        if (got <= 0)
+            return false;
+        end_ += static_cast<size_t>(got);
+        return true;
+    }
+
+    int fd_;
+    std::vector<char> buffer_;
+    size_t pos_ = 0, end_ = 0;
+    std::string_view line_;
+    int key_ = 0;
+    bool has_key_ = false;
+};
+
+// Tournament (loser) tree over k run readers. The root holds the current
+// winner; replacing it replays only the log2(k) matches on its leaf's path.
+// Ties go to the lower run index, which keeps the merge stable.
+class LoserTree {
+public:
+    explicit LoserTree(std::vector<std::unique_ptr<RunReader>>& runs)
+        : runs_(runs), k_(runs.size()), live_(k_), tree_(k_, k_) {
+        for (size_t i = 0; i < k_; ++i)
+            live_[i] = runs_[i]->next();
+        for (size_t i = k_; i-- > 0;)
+            replay(i);
+    }
+
+    bool empty() const { return k_ == 0 || !live_[tree_[0]]; }
+    RunReader& top() { return *runs_[tree_[0]]; }
+
+    // Advance the winning run and find the new winner
+    void pop() {
+        size_t winner = tree_[0];
+        live_[winner] = runs_[winner]->next();
+        replay(winner);
+    }
+
+private:
+    // True if run a must come after run b. Index k_ is the "minus infinity"
+    // placeholder used while building; an exhausted run is "plus infinity".
+    bool loses(size_t a, size_t b) const {
+        if (a == k_) return false;
+        if (b == k_) return true;
+        if (!live_[a]) return live_[b] || a > b;
+        if (!live_[b]) return false;
+        int ka = runs_[a]->key(), kb = runs_[b]->key();
+        return ka > kb || (ka == kb && a > b);
+    }
+
+    void replay(size_t leaf) {
+        size_t winner = leaf;
+        for (size_t node = (leaf + k_) / 2; node > 0; node /= 2) {
+            if (loses(winner, tree_[node]))
+                std::swap(winner, tree_[node]);   // Loser stays, winner moves up
+        }
+        tree_[0] = winner;
+    }
+
+    std::vector<std::unique_ptr<RunReader>>& runs_;
+    size_t k_;
+    std::vector<char> live_;
+    std::vector<size_t> tree_;   // tree_[0] is the winner, the rest hold losers
+};
+
+// Out-of-core stable merge sort of a CSV file under a memory budget.
+//
+// Run formation streams the mapped input, parses rows until the budget is
+// reached, sorts them with the caller's in-memory stable sort and spills them
+// as "key,word\n" text to a temporary file, dropping the consumed input pages.
+// The runs are then merged through a loser tree with large sequential read
+// and write buffers; more than kMaxFanIn runs are merged in several passes.
+// Runs hold consecutive input rows and ties go to the earlier run, so the
+// output is the same stable order as sorting everything in memory.
+class ExternalMergeSort {
+public:
+    static constexpr size_t kMaxFanIn = 256;
+
+    ExternalMergeSort(size_t memory_limit_bytes, const std::string& temp_dir)
+        : memory_limit_(memory_limit_bytes < (1 << 20) ? (1 << 20) : memory_limit_bytes),
+          temp_dir_(temp_dir.empty() ? "." : temp_dir) {}
+
+    ~ExternalMergeSort() {
+        for (const std::string& run : runs_)
+            std::remove(run.c_str());
+    }
+
+    // Split the input into sorted runs on disk; returns the number of rows
+    // kept, or sets opened = false if the input cannot be mapped. failed()
+    // reports whether a run could not be written.
+    template <typename OnBadRow, typename SortRun>
+    size_t create_runs(const std::string& filename, bool& opened, OnBadRow on_bad_row, SortRun sort_run) {
+        MappedFile file;
+        opened = file.open(filename);
+        if (!opened)
+            return 0;
+
+        const char* base = file.data();
+        const char* p = base;
+        const char* end = base + file.size();
+        const char* run_start = p;
+        size_t rows_total = 0, row_num = 0;
+        std::vector<Record> rows;
+
+        while (p < end) {
+            // Each row costs its text plus a Record and the sort's scratch copy
+            size_t budget_used = 0;
+            rows.clear();
+            while (p < end && budget_used < memory_limit_) {
+                const char* nl = static_cast<const char*>(memchr(p, '\n', end - p));
+                const char* line_end = nl ? nl : end;
+                parse_csv_line(p, line_end, ++row_num, rows, on_bad_row);
+                budget_used += (line_end - p + 1) + 2 * sizeof(Record);
+                p = line_end + 1;
+            }
+
+            sort_run(rows);
+            if (!rows.empty() && !spill(rows)) {
+                failed_ = true;
+                return rows_total;
+            }
+            rows_total += rows.size();
+
+            // The run is on disk; let the kernel drop the input pages it used
+            release_pages(base, run_start, p < end ? p : end);
+            run_start = p;
+        }
+        return rows_total;
+    }
+
+    // Merge all runs into output_filename; returns false on I/O failure
+    bool merge_runs(const std::string& output_filename) {
+        while (runs_.size() > kMaxFanIn) {
+            std::vector<std::string> next;
+            for (size_t i = 0; i < runs_.size(); i += kMaxFanIn) {
+                size_t last = std::min(runs_.size(), i + kMaxFanIn);
+                std::string merged = next_run_name();
+                if (!merge_group(i, last, merged)) {
+                    // This pass's outputs are not in runs_ yet, so the destructor would leave them behind
+                    std::remove(merged.c_str());
+                    for (const std::string& run : next)
+                        std::remove(run.c_str());
+                    return false;
+                }
+                for (size_t r = i; r < last; ++r)
+                    std::remove(runs_[r].c_str());
+                next.push_back(merged);
+            }
+            runs_.swap(next);
+        }
+        return merge_group(0, runs_.size(), output_filename);
+    }
+
+    size_t run_count() const { return runs_.size(); }
+    bool failed() const { return failed_; }
+
+private:
+    std::string next_run_name() {
+        return temp_dir_ + "/merge_sort_run_" + std::to_string(getpid()) + "_" +
+               std::to_string(next_run_id_++) + ".tmp";
+    }
+
+    bool spill(const std::vector<Record>& rows) {
+        std::string name = next_run_name();
+        runs_.push_back(name);
+        CsvBlockWriter out(name, kWriteBuffer);
+        if (!out.is_open())
+            return false;
+        for (const Record& row : rows)
+            out.write_record(row.first, row.second);
+        out.flush();
+        return out.good();
+    }
+
+    // k-way merge of runs_[first, last) with the budget split across the readers
+    bool merge_group(size_t first, size_t last, const std::string& output_filename) {
+        size_t k = last - first;
+        size_t read_buffer = memory_limit_ / (k + 1);
+        std::vector<std::unique_ptr<RunReader>> readers;
+        for (size_t r = first; r < last; ++r) {
+            readers.emplace_back(new RunReader(runs_[r], read_buffer));
+            if (!readers.back()->is_open())
+                return false;
+        }
+
+        CsvBlockWriter out(output_filename, std::min(read_buffer, kWriteBuffer));
+        if (!out.is_open())
+            return false;
+        for (LoserTree tree(readers); !tree.empty(); tree.pop())
+            out.write_line(tree.top().line());
+        out.flush();
+        return out.good();
+    }
+
+    static void release_pages(const char* base, const char* from, const char* to) {
+        const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        size_t begin = ((from - base) + page - 1) / page * page;
+        size_t finish = (to - base) / page * page;
+        if (finish > begin)
+            madvise(const_cast<char*>(base) + begin, finish - begin, MADV_DONTNEED);
+    }
+
+    static constexpr size_t kWriteBuffer = 8 << 20;
+
+    size_t memory_limit_;
+    std::string temp_dir_;
+    std::vector<std::string> runs_;
+    size_t next_run_id_ = 0;
+    bool failed_ = false;
+};
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+// Sorted keys rearranged in Eytzinger (BFS heap) order: node k has children
+// 2k and 2k+1, so the first levels of every search share the same few cache
+// lines and each step's two possible successors are adjacent. With 64-byte
+// alignment, the 16 descendants four levels down from node k are one cache
+// line, which the search prefetches while it walks the next four levels.
+// Each node also remembers its position in the sorted array, so a hit gives
+// the row index of the (int, string) record it came from.
+class EytzingerIndex {
+public:
+    EytzingerIndex() = default;
+
+    // sorted_keys must be in ascending order
+    explicit EytzingerIndex(const std::vector<int32_t>& sorted_keys)
+        : n_(sorted_keys.size()),
+          keys_(allocate(n_ + 1)),
+          rows_(n_ + 1) {
+        size_t next = 0;
+        fill(sorted_keys, next, 1);
+    }
+
+    size_t size() const { return n_; }
+
+    // Sorted-array index of the first key not less than target (n if none)
+    size_t lower_bound(int32_t target) const {
+        size_t k = descend(target);
+        return k == 0 ? n_ : rows_[k];
+    }
+
+    // Row index of target or -1, like binary_search
+    int find(int32_t target) const {
+        size_t k = descend(target);
+        return (k != 0 && keys_[k] == target) ? static_cast<int>(rows_[k]) : -1;
+    }
+
+private:
+    static constexpr size_t kBlock = 16;   // int32 keys per 64-byte cache line
+
+    struct FreeDeleter {
+        void operator()(int32_t* p) const { std::free(p); }
+    };
+
+    // Branchless walk to a leaf, then undo the trailing right turns plus one
+    // left turn: the result is the node holding the lower bound, or 0 if every
+    // key is less than target
+    size_t descend(int32_t target) const {
+        const int32_t* keys = keys_.get();
+        size_t k = 1;
+        while (k <= n_) {
+            __builtin_prefetch(keys + k * kBlock);
+            k = 2 * k + (keys[k] < target);
+        }
+        return k >> __builtin_ffsll(~static_cast<long long>(k));
+    }
+
+    // Cache-line aligned key storage; slot 0 is unused so the root is slot 1
+    static std::unique_ptr<int32_t[], FreeDeleter> allocate(size_t count) {
+        size_t bytes = (count * sizeof(int32_t) + 63) / 64 * 64;
+        return std::unique_ptr<int32_t[], FreeDeleter>(static_cast<int32_t*>(std::aligned_alloc(64, bytes)));
+    }
+
+    // In-order walk of the implicit tree hands out sorted keys left to right
+    void fill(const std::vector<int32_t>& sorted_keys, size_t& next, size_t k) {
+        if (k > n_)
+            return;
+        fill(sorted_keys, next, 2 * k);
+        keys_[k] = sorted_keys[next];
+        rows_[k] = static_cast<uint32_t>(next);
+        ++next;
+        fill(sorted_keys, next, 2 * k + 1);
+    }
+
+    size_t n_ = 0;
+    std::unique_ptr<int32_t[], FreeDeleter> keys_;
+    std::vector<uint32_t> rows_;
+};
@@ -0,0 +1,246 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <sys/stat.h>
+
+#include "csv_writer.hpp"
+#include "external_merge_sort.hpp"
+
+// Keeping a sorted dataset up to date without re-sorting all of it. New rows
+// (the delta) are sorted in memory, then either
+//   - merged with the existing sorted CSV in one streaming pass into a new
+//     sorted file (merge_sorted_delta), or
+//   - added as one more sorted run of an LSM-style run set (LsmRunSet) that
+//     binary_search can query across (see lsm_index.hpp), with neighbouring
+//     runs merged only while they are of similar size.
+// Either way the refresh costs O(delta log delta) plus one sequential pass,
+// not a sort of the whole dataset. Ties always go to the older rows, so the
+// result is the order a stable sort of old rows followed by new rows gives.
+
+// Sorted in-memory rows read as "key,word\n" lines, like a RunReader
+class RecordLineSource {
+public:
+    explicit RecordLineSource(const std::vector<Record>& rows) : rows_(rows) {}
+
+    bool next() {
+        if (pos_ == rows_.size())
+            return false;
+        const Record& row = rows_[pos_++];
+        line_.resize(kMaxDecimalDigits + row.second.size() + 2);
+        char* out = format_decimal(&line_[0], row.first);
+        *out++ = ',';
+        memcpy(out, row.second.data(), row.second.size());
+        out += row.second.size();
+        *out++ = '\n';
+        length_ = out - line_.data();
+        key_ = row.first;
+        return true;
+    }
+
+    int key() const { return key_; }
+    bool has_key() const { return true; }
+    std::string_view line() const { return std::string_view(line_.data(), length_); }
+
+private:
+    const std::vector<Record>& rows_;
+    size_t pos_ = 0;
+    std::string line_;
+    size_t length_ = 0;
+    int key_ = 0;
+};
+
+// Why a streaming merge stopped early
+enum class MergeError {
+    None,
+    Unsorted,   // a source's keys went down, or a line had no key
+    Write       // the output could not be written
+};
+
+// Stable two-way merge of sorted line sources into out; on equal keys the
+// older source goes first. Counts the lines taken from each source.
+template <typename Older, typename Newer>
+MergeError merge_sorted_sources(Older& older, Newer& newer, CsvBlockWriter& out, size_t& older_lines,
+                                size_t& newer_lines) {
+    older_lines = newer_lines = 0;
+    bool older_live = older.next(), newer_live = newer.next();
+    int older_last = 0, newer_last = 0;
+    while (older_live || newer_live) {
+        bool take_older = older_live && (!newer_live || older.key() <= newer.key());
+        if (take_older) {
+            if (!older.has_key() || (older_lines > 0 && older.key() < older_last))
+                return MergeError::Unsorted;
+            older_last = older.key();
+            out.write_line(older.line());
+            ++older_lines;
+            older_live = older.next();
+        } else {
+            if (!newer.has_key() || (newer_lines > 0 && newer.key() < newer_last))
+                return MergeError::Unsorted;
+            newer_last = newer.key();
+            out.write_line(newer.line());
+            ++newer_lines;
+            newer_live = newer.next();
+        }
+    }
+    out.flush();
+    return out.good() ? MergeError::None : MergeError::Write;
+}
+
+// Merge the sorted CSV base_filename with the sorted delta rows into
+// output_filename; base_rows receives the number of rows read from the base.
+// Returns false and sets error if the base cannot be read, is not sorted, or
+// the output cannot be written.
+inline bool merge_sorted_delta(const std::string& base_filename, const std::vector<Record>& delta,
+                               const std::string& output_filename, size_t& base_rows, std::string& error) {
+    RunReader base(base_filename, 8 << 20);
+    if (!base.is_open()) {
+        error = "The base file '" + base_filename + "' could not be opened.";
+        return false;
+    }
+    CsvBlockWriter out(output_filename, 8 << 20, true);
+    if (!out.is_open()) {
+        error = "Unable to write to the file '" + output_filename + "'.";
+        return false;
+    }
+    RecordLineSource rows(delta);
+    size_t delta_rows = 0;
+    MergeError result = merge_sorted_sources(base, rows, out, base_rows, delta_rows);
+    if (result == MergeError::Unsorted)
+        error = "The base file '" + base_filename + "' is not a sorted \"int,word\" CSV.";
+    else if (result == MergeError::Write)
+        error = "An error occurred while writing the CSV: " + output_filename;
+    return result == MergeError::None;
+}
+
+// A directory of sorted runs, oldest first, listed one file name per line in
+// its MANIFEST. Each run is a sorted "key,word" CSV named run_<id>.csv. Adding
+// a run merges it with the one before while that one is at most kGrowthFactor
+// times larger (by bytes), so run sizes grow geometrically: there are
+// O(log n) runs and each row is rewritten O(log n) times over its lifetime.
+class LsmRunSet {
+public:
+    static constexpr size_t kGrowthFactor = 2;
+
+    explicit LsmRunSet(const std::string& directory) : directory_(directory) {}
+
+    // Read the manifest; a directory without one is an empty run set.
+    // Returns false if the directory does not exist.
+    bool open() {
+        struct stat info;
+        if (stat(directory_.c_str(), &info) != 0 || !S_ISDIR(info.st_mode))
+            return false;
+        runs_.clear();
+        std::ifstream manifest(path("MANIFEST"));
+        std::string name;
+        while (std::getline(manifest, name))
+            if (!name.empty())
+                runs_.push_back(name);
+        return true;
+    }
+
+    const std::vector<std::string>& runs() const { return runs_; }
+    std::string path(const std::string& name) const { return directory_ + "/" + name; }
+
+    // Write the sorted rows as the newest run, then merge runs of similar
+    // size; merges counts the merges done. Returns false and sets error on I/O failure.
+    bool add_run(const std::vector<Record>& sorted_rows, size_t& merges, std::string& error) {
+        merges = 0;
+        std::string name = next_run_name();
+        {
+            CsvBlockWriter out(path(name), 8 << 20, true);
+            if (out.is_open()) {
+                for (const Record& row : sorted_rows)
+                    out.write_record(row.first, row.second);
+                out.flush();
+            }
+            if (!out.good()) {
+                error = "Unable to write the run '" + path(name) + "'.";
+                return false;
+            }
+        }
+        runs_.push_back(name);
+
+        while (runs_.size() > 1 && file_size(runs_[runs_.size() - 2]) <= kGrowthFactor * file_size(runs_.back())) {
+            if (!merge_newest_two(error))
+                return false;
+            ++merges;
+        }
+        return write_manifest(error);
+    }
+
+private:
+    std::string directory_;
+    std::vector<std::string> runs_;
+    std::vector<std::string> stale_;   // Merged away; deleted once the manifest no longer lists them
+
+    size_t file_size(const std::string& name) const {
+        struct stat info;
+        return stat(path(name).c_str(), &info) == 0 ? static_cast<size_t>(info.st_size) : 0;
+    }
+
+    // run_<id>.csv with an id above every run listed
+    std::string next_run_name() const {
+        unsigned long id = 0;
+        for (const std::string& run : runs_) {
+            unsigned long run_id = 0;
+            if (sscanf(run.c_str(), "run_%lu.csv", &run_id) == 1)
+                id = std::max(id, run_id + 1);
+        }
+        return "run_" + std::to_string(id) + ".csv";
+    }
+
+    // Replace the two newest runs with their merge
+    bool merge_newest_two(std::string& error) {
+        const std::string older_name = runs_[runs_.size() - 2], newer_name = runs_.back();
+        const std::string merged_name = next_run_name();
+        {
+            RunReader older(path(older_name), 8 << 20), newer(path(newer_name), 8 << 20);
+            CsvBlockWriter out(path(merged_name), 8 << 20, true);
+            if (!older.is_open() || !newer.is_open() || !out.is_open()) {
+                error = "Unable to merge the runs '" + older_name + "' and '" + newer_name + "'.";
+                return false;
+            }
+            size_t older_lines, newer_lines;
+            if (merge_sorted_sources(older, newer, out, older_lines, newer_lines) != MergeError::None) {
+                error = "Unable to merge the runs '" + older_name + "' and '" + newer_name + "'.";
+                return false;
+            }
+        }
+        runs_.pop_back();
+        runs_.back() = merged_name;
+        stale_.push_back(older_name);
+        stale_.push_back(newer_name);
+        return true;
+    }
+
+    // Replace the manifest atomically, then delete the runs it no longer lists
+    bool write_manifest(std::string& error) {
+        const std::string temp = path("MANIFEST.tmp");
+        {
+            std::ofstream manifest(temp);
+            for (const std::string& run : runs_)
+                manifest << run << "\n";
+            if (!manifest) {
+                error = "Unable to write '" + temp + "'.";
+                return false;
+            }
+        }
+        if (std::rename(temp.c_str(), path("MANIFEST").c_str()) != 0) {
+            error = "Unable to replace '" + path("MANIFEST") + "'.";
+            return false;
+        }
+        for (const std::string& run : stale_)
+            if (std::find(runs_.begin(), runs_.end(), run) == runs_.end())
+                std::remove(path(run).c_str());
+        stale_.clear();
+        return true;
+    }
+};
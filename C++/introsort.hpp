@@ -0,0 +1,130 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include "thread_pool.hpp"
+
+// Introsort for pair-like elements ordered by .first.
+//
+// The pivot is the median of three (ninther on large ranges), partitioning
+// is Hoare style, ranges of 16 or fewer are insertion sorted, and a range
+// that recurses deeper than 2*log2(n) is finished with heapsort so sorted or
+// adversarial input stays O(n log n). Only the smaller side is recursed
+// into; the larger side is handled by the loop, bounding stack depth by
+// log2(n). With a pool, subranges larger than `parallel_cutoff` are forked
+// onto it. Like the classic quick sort, equal keys may be reordered.
+template <typename T>
+class IntroSort {
+public:
+    // pool may be null for a single-threaded sort
+    IntroSort(ThreadPool* pool, size_t parallel_cutoff)
+        : pool_(pool), parallel_cutoff_(std::max<size_t>(parallel_cutoff, 2)) {}
+
+    void sort(std::vector<T>& v) {
+        if (v.size() < 2)
+            return;
+        int depth_limit = 0;
+        for (size_t n = v.size(); n > 1; n >>= 1)
+            depth_limit += 2;                     // 2 * floor(log2 n)
+
+        if (!pool_) {
+            sort_range(v.data(), 0, v.size(), depth_limit, nullptr);
+            return;
+        }
+        TaskGroup group(*pool_);
+        sort_range(v.data(), 0, v.size(), depth_limit, &group);
+        group.wait();
+    }
+
+private:
+    static constexpr size_t kInsertionLimit = 16;
+    static constexpr size_t kNintherLimit = 128;
+
+    // Sort a[lo, hi)
+    void sort_range(T* a, size_t lo, size_t hi, int depth_limit, TaskGroup* group) {
+        while (hi - lo > kInsertionLimit) {
+            if (depth_limit-- == 0) {
+                heap_sort(a + lo, a + hi);
+                return;
+            }
+
+            size_t split = hoare_partition(a, lo, hi);   // [lo, split] <= pivot <= [split + 1, hi)
+            size_t left_lo = lo, left_hi = split + 1;
+            size_t right_lo = split + 1, right_hi = hi;
+
+            // Recurse (or fork) on the smaller side, keep looping on the larger one
+            if (left_hi - left_lo > right_hi - right_lo) {
+                std::swap(left_lo, right_lo);
+                std::swap(left_hi, right_hi);
+            }
+            if (group && left_hi - left_lo > parallel_cutoff_) {
+                group->run([=]() { sort_range(a, left_lo, left_hi, depth_limit, group); });
+            } else {
+                sort_range(a, left_lo, left_hi, depth_limit, group);
+            }
+            lo = right_lo;
+            hi = right_hi;
+        }
+        insertion_sort(a, lo, hi);
+    }
+
+    static void sort3(T* a, size_t x, size_t y, size_t z) {
+        if (a[y].first < a[x].first) std::swap(a[x], a[y]);
+        if (a[z].first < a[y].first) std::swap(a[y], a[z]);
+        if (a[y].first < a[x].first) std::swap(a[x], a[y]);
+    }
+
+    // Move the median of three (or of three medians) to a[lo]
+    static void choose_pivot(T* a, size_t lo, size_t hi) {
+        size_t n = hi - lo, mid = lo + n / 2;
+        if (n > kNintherLimit) {
+            size_t step = n / 8;
+            sort3(a, lo, lo + step, lo + 2 * step);
+            sort3(a, mid - step, mid, mid + step);
+            sort3(a, hi - 1 - 2 * step, hi - 1 - step, hi - 1);
+            sort3(a, lo + step, mid, hi - 1 - step);
+        } else {
+            sort3(a, lo, mid, hi - 1);
+        }
+        std::swap(a[lo], a[mid]);
+    }
+
+    // Hoare partition of a[lo, hi) around the key at a[lo]; returns the last
+    // index of the left part, and both parts are non-empty
+    static size_t hoare_partition(T* a, size_t lo, size_t hi) {
+        choose_pivot(a, lo, hi);
+        const int pivot = a[lo].first;
+        size_t i = lo - 1, j = hi;
+        for (;;) {
+            do { ++i; } while (a[i].first < pivot);
+            do { --j; } while (a[j].first > pivot);
+            if (i >= j)
+                return j;
+            std::swap(a[i], a[j]);
+        }
+    }
+
+    static void insertion_sort(T* a, size_t lo, size_t hi) {
+        for (size_t i = lo + 1; i < hi; ++i) {
+            T item = std::move(a[i]);
+            size_t j = i;
+            while (j > lo && a[j - 1].first > item.first) {
+                a[j] = std::move(a[j - 1]);
+                --j;
+            }
+            a[j] = std::move(item);
+        }
+    }
+
+    static void heap_sort(T* first, T* last) {
+        auto by_key = [](const T& x, const T& y) { return x.first < y.first; };
+        std::make_heap(first, last, by_key);
+        std::sort_heap(first, last, by_key);
+    }
+
+    ThreadPool* pool_;
+    size_t parallel_cutoff_;
+};
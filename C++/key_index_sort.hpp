@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "csv_loader.hpp"
+
+// Sort key packed with the position of its row in the unsorted vector.
+// At 8 bytes it is a third of a Record, and the word never moves while
+// comparisons and swaps run; rows are limited to 2^32 by the index width.
+using KeyIndex = std::pair<int, uint32_t>;
+
+// Pack every row's key and position into a contiguous array; Row is Record or
+// any other record type with an int .first
+template <typename Row>
+std::vector<KeyIndex> extract_key_index(const std::vector<Row>& rows) {
+    std::vector<KeyIndex> keys(rows.size());
+    for (size_t i = 0; i < rows.size(); ++i)
+        keys[i] = KeyIndex(rows[i].first, static_cast<uint32_t>(i));
+    return keys;
+}
+
+// Reorder rows to follow the sorted keys, moving each row exactly once
+template <typename Row>
+void apply_key_index_order(std::vector<Row>& rows, const std::vector<KeyIndex>& order) {
+    std::vector<Row> sorted(rows.size());
+    for (size_t i = 0; i < order.size(); ++i)
+        sorted[i] = rows[order[i].second];
+    rows.swap(sorted);
+}
+
+// Sort rows by key through the packed array: sort_keys(vector<KeyIndex>&)
+// orders the keys with any algorithm, then the payload permutation is
+// applied once. Running the same algorithm as on the full rows gives the
+// same order, ties included, because only .first is ever compared.
+template <typename Row, typename SortKeys>
+void sort_by_key_index(std::vector<Row>& rows, SortKeys sort_keys) {
+    std::vector<KeyIndex> keys = extract_key_index(rows);
+    sort_keys(keys);
+    apply_key_index_order(rows, keys);
+}
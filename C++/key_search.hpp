@@ -0,0 +1,203 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define KEY_SEARCH_HAVE_X86 1
+#endif
+
+#include "csv_loader.hpp"
+
+// Search kernels over a packed int32 key column. Probing 4-byte keys instead
+// of 24-byte records fits six times more of the search path in each cache
+// line, and the lockstep batch kernels overlap the cache misses of many
+// queries. The searches compute lower_bound (the first index whose key is
+// not less than the target, n if there is none) unless named otherwise.
+
+// Copy the key of every row into a contiguous array
+inline std::vector<int32_t> extract_keys(const std::vector<Record>& rows) {
+    std::vector<int32_t> keys(rows.size());
+    for (size_t i = 0; i < rows.size(); ++i)
+        keys[i] = rows[i].first;
+    return keys;
+}
+
+// Branchless lower_bound: the number of halving steps depends only on n,
+// and each step is a conditional add instead of an unpredictable branch
+inline size_t branchless_lower_bound(const int32_t* keys, size_t n, int32_t target) {
+    if (n == 0)
+        return 0;
+    const int32_t* base = keys;
+    while (n > 1) {
+        size_t half = n / 2;
+        base += (base[half - 1] < target) ? half : 0;
+        n -= half;
+    }
+    return (base - keys) + (*base < target);
+}
+
+// Branchless upper_bound: the first index whose key is greater than target
+inline size_t branchless_upper_bound(const int32_t* keys, size_t n, int32_t target) {
+    if (n == 0)
+        return 0;
+    const int32_t* base = keys;
+    while (n > 1) {
+        size_t half = n / 2;
+        base += (base[half - 1] <= target) ? half : 0;
+        n -= half;
+    }
+    return (base - keys) + (*base <= target);
+}
+
+// Half-open index range [first, last) of the keys equal to target; empty
+// (first == last) at the insertion point if there are none
+struct IndexRange {
+    size_t first = 0;
+    size_t last = 0;
+    size_t size() const { return last - first; }
+};
+
+inline IndexRange equal_key_range(const int32_t* keys, size_t n, int32_t target) {
+    IndexRange range;
+    range.first = branchless_lower_bound(keys, n, target);
+    range.last = range.first + branchless_upper_bound(keys + range.first, n - range.first, target);
+    return range;
+}
+
+// Index of target or -1, like binary_search, via the branchless kernel
+inline int find_key(const int32_t* keys, size_t n, int32_t target) {
+    size_t i = branchless_lower_bound(keys, n, target);
+    return (i < n && keys[i] == target) ? static_cast<int>(i) : -1;
+}
+
+// A run of consecutive records viewed in place (std::span is C++20). A range
+// scan hands one back instead of copying the matches, so emitting a large
+// range only streams over the rows that are already in memory.
+struct RecordSpan {
+    const Record* first = nullptr;
+    const Record* last = nullptr;
+
+    const Record* begin() const { return first; }
+    const Record* end() const { return last; }
+    size_t size() const { return last - first; }
+    bool empty() const { return first == last; }
+};
+
+// Every record with lo <= key <= hi; keys is the key column of rows
+inline RecordSpan key_range(const std::vector<Record>& rows, const int32_t* keys, int32_t lo, int32_t hi) {
+    RecordSpan span;
+    span.first = span.last = rows.data();
+    if (lo > hi)
+        return span;
+    size_t first = branchless_lower_bound(keys, rows.size(), lo);
+    size_t last = first + branchless_upper_bound(keys + first, rows.size() - first, hi);
+    span.first = rows.data() + first;
+    span.last = rows.data() + last;
+    return span;
+}
+
+// Queries advanced together by the scalar batch kernel
+constexpr size_t kSearchLanes = 16;
+
+// Probe distances below this stay in nearby cache lines; no prefetch needed
+constexpr size_t kPrefetchMinHalf = 16;
+
+// lower_bound for `count` queries, kSearchLanes at a time in lockstep. Every
+// query in a group takes the same halving steps, so the loads of all lanes
+// are independent and their misses overlap. Each lane also prefetches both
+// keys it may probe two steps ahead, so those loads are already in flight.
+inline void batch_lower_bound_scalar(const int32_t* keys, size_t n, const int32_t* queries,
+                                     size_t count, size_t* out) {
+    for (size_t q0 = 0; q0 < count; q0 += kSearchLanes) {
+        size_t lanes = count - q0 < kSearchLanes ? count - q0 : kSearchLanes;
+        if (n == 0) {
+            for (size_t l = 0; l < lanes; ++l)
+                out[q0 + l] = 0;
+            continue;
+        }
+        size_t base[kSearchLanes] = {};
+        size_t len = n;
+        while (len > 1) {
+            size_t half = len / 2;
+            for (size_t l = 0; l < lanes; ++l)
+                base[l] += (keys[base[l] + half - 1] < queries[q0 + l]) ? half : 0;
+            len -= half;
+            size_t next = len / 2, after = (len - next) / 2;
+            if (after >= kPrefetchMinHalf) {
+                for (size_t l = 0; l < lanes; ++l) {
+                    __builtin_prefetch(keys + base[l] + after - 1);
+                    __builtin_prefetch(keys + base[l] + next + after - 1);
+                }
+            }
+        }
+        for (size_t l = 0; l < lanes; ++l)
+            out[q0 + l] = base[l] + (keys[base[l]] < queries[q0 + l]);
+    }
+}
+
+#ifdef KEY_SEARCH_HAVE_X86
+// AVX2 version: 8 queries per vector, probes fetched with one gather per step.
+// Requires n < 2^31 so indices fit the gather's int32 lanes.
+__attribute__((target("avx2")))
+inline void batch_lower_bound_avx2(const int32_t* keys, size_t n, const int32_t* queries,
+                                   size_t count, size_t* out) {
+    const size_t kLanes = 8;
+    size_t q0 = 0;
+    for (; n > 0 && q0 + kLanes <= count; q0 += kLanes) {
+        __m256i target = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(queries + q0));
+        __m256i base = _mm256_setzero_si256();
+        size_t len = n;
+        while (len > 1) {
+            size_t half = len / 2;
+            __m256i probe_index = _mm256_add_epi32(base, _mm256_set1_epi32(static_cast<int>(half - 1)));
+            __m256i probe = _mm256_i32gather_epi32(reinterpret_cast<const int*>(keys), probe_index, 4);
+            __m256i less = _mm256_cmpgt_epi32(target, probe);   // probe < target
+            base = _mm256_add_epi32(base, _mm256_and_si256(less, _mm256_set1_epi32(static_cast<int>(half))));
+            len -= half;
+
+            size_t next = len / 2, after = (len - next) / 2;
+            if (after >= kPrefetchMinHalf) {
+                alignas(32) int32_t lane_base[kLanes];
+                _mm256_store_si256(reinterpret_cast<__m256i*>(lane_base), base);
+                for (size_t l = 0; l < kLanes; ++l) {
+                    __builtin_prefetch(keys + lane_base[l] + after - 1);
+                    __builtin_prefetch(keys + lane_base[l] + next + after - 1);
+                }
+            }
+        }
+        __m256i last = _mm256_i32gather_epi32(reinterpret_cast<const int*>(keys), base, 4);
+        __m256i less = _mm256_cmpgt_epi32(target, last);
+        base = _mm256_sub_epi32(base, less);                    // less is -1 where true
+        alignas(32) int32_t result[kLanes];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(result), base);
+        for (size_t l = 0; l < kLanes; ++l)
+            out[q0 + l] = static_cast<size_t>(result[l]);
+    }
+    batch_lower_bound_scalar(keys, n, queries + q0, count - q0, out + q0);
+}
+#endif
+
+// True if the batch kernel will use AVX2 on this CPU
+inline bool batch_search_uses_avx2(size_t n) {
+#ifdef KEY_SEARCH_HAVE_X86
+    return n < (size_t(1) << 31) && __builtin_cpu_supports("avx2");
+#else
+    (void)n;
+    return false;
+#endif
+}
+
+// lower_bound for a batch of queries: AVX2 when the CPU has it, else scalar lockstep
+inline void batch_lower_bound(const int32_t* keys, size_t n, const int32_t* queries,
+                              size_t count, size_t* out) {
+#ifdef KEY_SEARCH_HAVE_X86
+    if (batch_search_uses_avx2(n)) {
+        batch_lower_bound_avx2(keys, n, queries, count, out);
+        return;
+    }
+#endif
+    batch_lower_bound_scalar(keys, n, queries, count, out);
+}
@@ -0,0 +1,524 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <charconv>
+#include <condition_variable>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <dirent.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "binary_dataset.hpp"
+#include "cli_options.hpp"
+#include "key_search.hpp"
+
+using namespace std;
+using namespace std::chrono;
+
+// A sorted dataset as served: the mapped rows plus their packed key column.
+// A reload builds a new snapshot and swaps it in; requests already holding
+// the old one finish on it, and it is unmapped when the last one lets go.
+struct Snapshot {
+    string filename;
+    long long mtime_ns = 0;   // Modification time when loaded
+    Dataset dataset;
+    vector<int32_t> keys;
+};
+
+// Splits the bytes read from a file descriptor into lines
+class LineReader {
+public:
+    explicit LineReader(int fd) : fd_(fd), buffer_(64 << 10) {}
+
+    // Read whatever input is available after the unconsumed bytes; false at
+    // end of input. Invalidates lines returned earlier.
+    bool fill() {
+        memmove(buffer_.data(), buffer_.data() + pos_, end_ - pos_);
+        end_ -= pos_;
+        pos_ = 0;
+        if (end_ == buffer_.size())
+            buffer_.resize(buffer_.size() * 2);   // One very long line
+        for (;;) {
+            ssize_t got = ::read(fd_, buffer_.data() + end_, buffer_.size() - end_);
+            if (got < 0 && errno == EINTR)
+                continue;
+            if (got <= 0)
+                return false;
+            end_ += static_cast<size_t>(got);
+            return true;
+        }
+    }
+
+    // Next complete buffered line without its "\r\n"; false if there is none
+    bool next_line(string_view& line) {
+        const char* start = buffer_.data() + pos_;
+        const char* nl = static_cast<const char*>(memchr(start, '\n', end_ - pos_));
+        if (!nl)
+            return false;
+        pos_ += (nl - start) + 1;
+        line = trim_cr(string_view(start, nl - start));
+        return true;
+    }
+
+    // A last line that ended without '\n'; only meaningful at end of input
+    bool last_line(string_view& line) {
+        if (pos_ == end_)
+            return false;
+        line = trim_cr(string_view(buffer_.data() + pos_, end_ - pos_));
+        pos_ = end_;
+        return true;
+    }
+
+private:
+    static string_view trim_cr(string_view line) {
+        if (!line.empty() && line.back() == '\r')
+            line.remove_suffix(1);
+        return line;
+    }
+
+    int fd_;
+    vector<char> buffer_;
+    size_t pos_ = 0, end_ = 0;
+};
+
+// Write all of data to fd; false if the peer has gone away
+bool write_all(int fd, const string& data) {
+    size_t done = 0;
+    while (done < data.size()) {
+        ssize_t wrote = ::write(fd, data.data() + done, data.size() - done);
+        if (wrote < 0 && errno == EINTR)
+            continue;
+        if (wrote <= 0)
+            return false;
+        done += static_cast<size_t>(wrote);
+    }
+    return true;
+}
+
+// Buffered replies are written out once they pass this size, so a wide range
+// streams in bounded chunks instead of being built whole in memory
+constexpr size_t kReplyChunkBytes = 64 << 10;
+
+// Socket path to remove when the server is stopped by a signal
+char socket_path_to_unlink[sizeof(sockaddr_un::sun_path)] = "";
+
+extern "C" void stop_server(int) {
+    if (socket_path_to_unlink[0] != '\0')
+        unlink(socket_path_to_unlink);
+    _exit(0);
+}
+
+// Long-running lookup service: the sorted dataset is loaded once and kept
+// resident, so a request costs one search instead of a file load and parse.
+//
+// Protocol: one request per line, replies in request order. Rows are
+// positions in the sorted dataset, and duplicate keys are reported from
+// their first row.
+//   <k>             ->  "<k>,<row>,<word>", or "<k>,-1," if the key is absent
+//   lower <k>       ->  "<k>,<i>": first row whose key is not less than k (n if none)
+//   upper <k>       ->  "<k>,<i>": first row whose key is greater than k (n if none)
+//   equal <k>       ->  "<k>,<first>,<last>": rows [first, last) have key k
+//   range <lo> <hi> ->  "<key>,<row>,<word>" for every row with lo <= key <= hi,
+//                       then "end,<count>"
+//   stats           ->  "dataset=<file> rows=<n> reloads=<k> queries=<q>"
+//   quit            ->  closes the connection (ends the server in stdin mode)
+// Requests may be pipelined: every complete line already received is
+// answered and all of their replies go out in one write.
+class LookupServer {
+public:
+    // Optional arguments:
+    //   --dataset=FILE     sorted CSV or .bin dataset to serve (otherwise asked for on stdin)
+    //   --socket=PATH      listen on a Unix domain socket instead of stdin/stdout
+    //   --threads=N        socket connections served at once (default: one per core)
+    //   --watch-dir=DIR    directory polled for new merge_sort_N.csv / quick_sort_N.csv
+    //                      files (default: the dataset's directory)
+    //   --poll-ms=N        reload poll interval in milliseconds (default 500, 0 = never reload)
+    int main(int argc, char* argv[]) {
+        string socket_path = option_value(argc, argv, "socket");
+        unsigned threads;
+        if (!option_threads(argc, argv, threads)) {
+            cerr << "Error: Invalid thread count '" << option_value(argc, argv, "threads") << "'." << endl;
+            return 1;
+        }
+        long poll_ms = option_number(argc, argv, "poll-ms", 500);
+
+        // In stdin mode stdout carries the replies, so the prompt goes to stderr
+        // and the file name is read through the same reader as the requests
+        LineReader input(STDIN_FILENO);
+        string filename = option_value(argc, argv, "dataset");
+        if (filename.empty()) {
+            cerr << "Enter CSV file name: ";
+            string_view line;
+            while (!input.next_line(line)) {
+                if (!input.fill()) {
+                    input.last_line(line);
+                    break;
+                }
+            }
+            filename = string(line);
+        }
+
+        auto start_time = high_resolution_clock::now();
+        shared_ptr<Snapshot> snapshot = load_snapshot(filename);
+        auto end_time = high_resolution_clock::now();
+        if (!snapshot)
+            return 1;
+        current_ = snapshot;
+
+        duration<double, milli> duration = end_time - start_time;
+        cerr << fixed << setprecision(3);
+        cerr << "Loaded " << snapshot->keys.size() << " records from " << filename << " in "
+             << duration.count() << " ms" << endl;
+
+        string watch_dir = option_value(argc, argv, "watch-dir");
+        if (watch_dir.empty()) {
+            size_t slash = filename.find_last_of('/');
+            watch_dir = (slash == string::npos) ? "." : filename.substr(0, slash);
+        }
+        thread watcher;
+        if (poll_ms > 0)
+            watcher = thread(&LookupServer::watch, this, watch_dir, poll_ms);
+
+        int status = 0;
+        if (socket_path.empty()) {
+            serve(input, STDOUT_FILENO);
+        } else {
+            status = serve_socket(socket_path, threads);
+        }
+
+        {
+            lock_guard<mutex> lock(stop_mutex_);
+            stopping_ = true;
+        }
+        stop_.notify_all();
+        if (watcher.joinable())
+            watcher.join();
+        return status;
+    }
+
+private:
+    // Load and check a sorted dataset; null (with a message) if it cannot be served
+    static shared_ptr<Snapshot> load_snapshot(const string& filename) {
+        shared_ptr<Snapshot> snapshot = make_shared<Snapshot>();
+        snapshot->filename = filename;
+        size_t skipped = 0;
+        bool opened = load_dataset(filename, snapshot->dataset, [&skipped](RowError, size_t, string_view) {
+            ++skipped;
+        });
+        if (!opened) {
+            cerr << "Error: The file '" << filename << "' was not found." << endl;
+            return nullptr;
+        }
+        if (skipped > 0)
+            cerr << "Skipped " << skipped << " invalid lines in " << filename << endl;
+        if (snapshot->dataset.rows.empty()) {
+            cerr << "Error: The dataset '" << filename << "' is empty." << endl;
+            return nullptr;
+        }
+        snapshot->keys = extract_keys(snapshot->dataset.rows);
+        if (!is_sorted(snapshot->keys.begin(), snapshot->keys.end())) {
+            cerr << "Error: The dataset '" << filename << "' is not sorted by key." << endl;
+            return nullptr;
+        }
+        struct stat info;
+        if (stat(filename.c_str(), &info) == 0)
+            snapshot->mtime_ns = info.st_mtim.tv_sec * 1000000000LL + info.st_mtim.tv_nsec;
+        return snapshot;
+    }
+
+    shared_ptr<const Snapshot> current() {
+        lock_guard<mutex> lock(snapshot_mutex_);
+        return current_;
+    }
+
+    static void append_number(string& replies, long long value) {
+        char digits[24];
+        char* end = to_chars(digits, digits + sizeof(digits), value).ptr;
+        replies.append(digits, end);
+    }
+
+    // "<key>,<row>,<word>\n", with no word when row is -1
+    static void append_row(string& replies, const Snapshot& snapshot, int key, long long row) {
+        append_number(replies, key);
+        replies += ',';
+        append_number(replies, row);
+        replies += ',';
+        if (row >= 0) {
+            string_view word = snapshot.dataset.rows[row].second;
+            if (!word.empty() && word.back() == '\r')
+                word.remove_suffix(1);
+            replies.append(word.data(), word.size());
+        }
+        replies += '\n';
+    }
+
+    // One whole request argument as an int. parse_int follows stoi and stops
+    // at the first non-digit, so "5abc" alone would read as 5; the argument
+    // must be an optional sign and digits only.
+    static bool parse_key(string_view text, int& value) {
+        size_t digits = (!text.empty() && (text[0] == '+' || text[0] == '-')) ? 1 : 0;
+        if (digits == text.size())
+            return false;
+        for (size_t i = digits; i < text.size(); ++i)
+            if (static_cast<unsigned>(text[i] - '0') >= 10)
+                return false;
+        return parse_int(text.data(), text.data() + text.size(), value);
+    }
+
+    // Parse `count` space-separated integers; false unless exactly that many are given
+    static bool parse_arguments(string_view text, int* values, size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            size_t start = text.find_first_not_of(' ');
+            if (start == string_view::npos)
+                return false;
+            text.remove_prefix(start);
+            size_t length = min(text.find(' '), text.size());
+            if (!parse_key(text.substr(0, length), values[i]))
+                return false;
+            text.remove_prefix(length);
+        }
+        return text.find_first_not_of(' ') == string_view::npos;
+    }
+
+    // Append the reply to one request; replies may be flushed to out_fd early.
+    // False if the client asked to quit or can no longer be written to.
+    bool answer(const Snapshot& snapshot, string_view request, string& replies, int out_fd) {
+        if (request == "quit")
+            return false;
+        if (request.empty())
+            return true;
+        if (request == "stats") {
+            replies += "dataset=" + snapshot.filename + " rows=" + to_string(snapshot.keys.size()) +
+                       " reloads=" + to_string(reloads_.load()) + " queries=" + to_string(queries_.load()) + "\n";
+            return true;
+        }
+
+        const int32_t* keys = snapshot.keys.data();
+        const size_t n = snapshot.keys.size();
+        size_t space = request.find(' ');
+        string_view command = request.substr(0, space);
+        string_view arguments = (space == string_view::npos) ? string_view() : request.substr(space + 1);
+        int values[2];
+
+        if ((command == "lower" || command == "upper" || command == "equal") && parse_arguments(arguments, values, 1)) {
+            queries_.fetch_add(1, memory_order_relaxed);
+            append_number(replies, values[0]);
+            replies += ',';
+            if (command == "lower") {
+                append_number(replies, branchless_lower_bound(keys, n, values[0]));
+            } else if (command == "upper") {
+                append_number(replies, branchless_upper_bound(keys, n, values[0]));
+            } else {
+                IndexRange range = equal_key_range(keys, n, values[0]);
+                append_number(replies, range.first);
+                replies += ',';
+                append_number(replies, range.last);
+            }
+            replies += '\n';
+            return true;
+        }
+        if (command == "range" && parse_arguments(arguments, values, 2)) {
+            queries_.fetch_add(1, memory_order_relaxed);
+            const vector<Record>& rows = snapshot.dataset.rows;
+            RecordSpan span = key_range(rows, keys, values[0], values[1]);
+            for (const Record& record : span) {
+                append_row(replies, snapshot, record.first, &record - rows.data());
+                if (replies.size() >= kReplyChunkBytes) {
+                    if (!write_all(out_fd, replies))
+                        return false;
+                    replies.clear();
+                }
+            }
+            replies += "end,";
+            append_number(replies, span.size());
+            replies += '\n';
+            return true;
+        }
+
+        int target;
+        if (space != string_view::npos || !parse_key(request, target)) {
+            replies += "error: invalid request '";
+            replies.append(request.data(), request.size());
+            replies += "'\n";
+            return true;
+        }
+        queries_.fetch_add(1, memory_order_relaxed);
+        append_row(replies, snapshot, target, find_key(keys, n, target));
+        return true;
+    }
+
+    // Answer requests from one input until it ends or asks to quit. Each batch
+    // of received lines is answered against one snapshot, so a reload never
+    // lands in the middle of a batch.
+    void serve(LineReader& reader, int out_fd) {
+        string replies;
+        bool open = true, more = true;
+        while (open) {
+            shared_ptr<const Snapshot> snapshot = current();
+            string_view line;
+            while (open && reader.next_line(line))
+                open = answer(*snapshot, line, replies, out_fd);
+            if (open && !more) {
+                if (reader.last_line(line))
+                    answer(*snapshot, line, replies, out_fd);
+                open = false;
+            }
+            if (!replies.empty() && !write_all(out_fd, replies))
+                open = false;
+            replies.clear();
+            if (open)
+                more = reader.fill();
+        }
+    }
+
+    // Accept connections on a Unix domain socket; every worker thread takes
+    // one connection at a time from the shared listening socket
+    int serve_socket(const string& path, unsigned threads) {
+        sockaddr_un address = {};
+        if (path.size() >= sizeof(address.sun_path)) {
+            cerr << "Error: Socket path '" << path << "' is too long." << endl;
+            return 1;
+        }
+        address.sun_family = AF_UNIX;
+        memcpy(address.sun_path, path.c_str(), path.size() + 1);
+
+        int listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        unlink(path.c_str());   // A stale socket from an earlier run
+        if (listen_fd < 0 || bind(listen_fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+            listen(listen_fd, SOMAXCONN) != 0) {
+            cerr << "Error: Cannot listen on '" << path << "': " << strerror(errno) << endl;
+            if (listen_fd >= 0)
+                close(listen_fd);
+            return 1;
+        }
+
+        memcpy(socket_path_to_unlink, path.c_str(), path.size() + 1);
+        signal(SIGINT, stop_server);
+        signal(SIGTERM, stop_server);
+        signal(SIGPIPE, SIG_IGN);   // A client that hangs up only ends its own connection
+
+        if (threads == 0)
+            threads = max(1u, thread::hardware_concurrency());
+        cerr << "Listening on " << path << " with " << threads << " workers" << endl;
+
+        vector<thread> workers;
+        for (unsigned i = 0; i < threads; ++i) {
+            workers.emplace_back([this, listen_fd]() {
+                for (;;) {
+                    int fd = accept(listen_fd, nullptr, nullptr);
+                    if (fd < 0) {
+                        if (errno == EINTR || errno == ECONNABORTED)
+                            continue;
+                        return;
+                    }
+                    LineReader reader(fd);
+                    serve(reader, fd);
+                    close(fd);
+                }
+            });
+        }
+        for (thread& worker : workers)
+            worker.join();
+        close(listen_fd);
+        unlink(path.c_str());
+        return 0;
+    }
+
+    // True for the sort tools' output names: merge_sort_N.csv or quick_sort_N.csv
+    static bool is_sorted_output_name(const string& name) {
+        for (const string prefix : {"merge_sort_", "quick_sort_"}) {
+            if (name.size() > prefix.size() + 4 && name.compare(0, prefix.size(), prefix) == 0 &&
+                name.compare(name.size() - 4, 4, ".csv") == 0) {
+                string digits = name.substr(prefix.size(), name.size() - prefix.size() - 4);
+                return all_of(digits.begin(), digits.end(), [](char c) { return c >= '0' && c <= '9'; });
+            }
+        }
+        return false;
+    }
+
+    // Poll dir for the most recently modified sort output. A file newer than
+    // the served dataset is loaded once its size has held still for one poll
+    // (the sort tool may still be writing it), then swapped in.
+    void watch(const string& dir, long poll_ms) {
+        string pending;
+        long long pending_size = -1, rejected_mtime = -1;
+        string rejected;
+        unique_lock<mutex> lock(stop_mutex_);
+        while (!stop_.wait_for(lock, milliseconds(poll_ms), [this] { return stopping_; })) {
+            string newest;
+            long long newest_mtime = 0, newest_size = 0;
+            if (DIR* listing = opendir(dir.c_str())) {
+                while (dirent* entry = readdir(listing)) {
+                    string name = entry->d_name;
+                    struct stat info;
+                    string path = (dir == ".") ? name : dir + "/" + name;
+                    if (!is_sorted_output_name(name) || stat(path.c_str(), &info) != 0)
+                        continue;
+                    long long mtime = info.st_mtim.tv_sec * 1000000000LL + info.st_mtim.tv_nsec;
+                    if (mtime > newest_mtime) {
+                        newest = path;
+                        newest_mtime = mtime;
+                        newest_size = info.st_size;
+                    }
+                }
+                closedir(listing);
+            }
+
+            if (newest.empty() || newest_mtime <= current()->mtime_ns ||
+                (newest == rejected && newest_mtime == rejected_mtime)) {
+                pending.clear();
+                continue;
+            }
+            if (newest != pending || newest_size != pending_size) {
+                pending = newest;                 // Check again next poll
+                pending_size = newest_size;
+                continue;
+            }
+            pending.clear();
+
+            lock.unlock();
+            auto start_time = high_resolution_clock::now();
+            shared_ptr<Snapshot> next = load_snapshot(newest);
+            auto end_time = high_resolution_clock::now();
+            lock.lock();
+            if (!next) {
+                rejected = newest;                // Do not retry until it changes
+                rejected_mtime = newest_mtime;
+                continue;
+            }
+            next->mtime_ns = max(next->mtime_ns, newest_mtime);
+            {
+                lock_guard<mutex> swap_lock(snapshot_mutex_);
+                current_ = next;
+            }
+            reloads_.fetch_add(1);
+            duration<double, milli> duration = end_time - start_time;
+            cerr << "Reloaded " << next->keys.size() << " records from " << newest << " in "
+                 << duration.count() << " ms" << endl;
+        }
+    }
+
+    mutex snapshot_mutex_;                  // Guards current_
+    shared_ptr<const Snapshot> current_;
+    atomic<long long> queries_{0};
+    atomic<long long> reloads_{0};
+
+    mutex stop_mutex_;                      // Guards stopping_
+    condition_variable stop_;
+    bool stopping_ = false;
+};
+
+int main(int argc, char* argv[]) {
+    LookupServer server;
+    return server.main(argc, argv);
+}
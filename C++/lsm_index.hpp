@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "binary_dataset.hpp"
+#include "incremental_merge.hpp"
+#include "key_search.hpp"
+
+// Lookups across every run of an LsmRunSet without compacting them. Each run
+// is loaded like any dataset, with its own packed key column. The runs are
+// sorted and older runs win ties, so the rows before a key's first match in
+// the fully merged order are exactly the rows below it in every run: a
+// lookup is one lower_bound per run, and the answer is the row (and word)
+// that full compaction would have given.
+class LsmIndex {
+public:
+    // Load every run listed in directory's manifest; false (with error set)
+    // if the directory or one of its runs cannot be read
+    template <typename OnBadRow>
+    bool open(const std::string& directory, OnBadRow on_bad_row, std::string& error) {
+        LsmRunSet set(directory);
+        if (!set.open()) {
+            error = "The run directory '" + directory + "' was not found.";
+            return false;
+        }
+        runs_.clear();
+        runs_.resize(set.runs().size());
+        rows_ = 0;
+        for (size_t r = 0; r < runs_.size(); ++r) {
+            if (!load_dataset(set.path(set.runs()[r]), runs_[r].data, on_bad_row)) {
+                error = "The run '" + set.path(set.runs()[r]) + "' could not be opened.";
+                return false;
+            }
+            runs_[r].keys = extract_keys(runs_[r].data.rows);
+            rows_ += runs_[r].keys.size();
+        }
+        return true;
+    }
+
+    size_t run_count() const { return runs_.size(); }
+    size_t size() const { return rows_; }
+
+    // Row of target's first record in the merged order of all runs, or -1;
+    // word receives that record's word
+    long long find(int32_t target, std::string_view& word) const {
+        size_t before = 0;
+        bool found = false;
+        for (const Run& run : runs_) {
+            size_t pos = branchless_lower_bound(run.keys.data(), run.keys.size(), target);
+            before += pos;
+            if (!found && pos < run.keys.size() && run.keys[pos] == target) {
+                found = true;   // The oldest run holding the key has its first record
+                word = run.data.rows[pos].second;
+            }
+        }
+        return found ? static_cast<long long>(before) : -1;
+    }
+
+private:
+    struct Run {
+        Dataset data;
+        std::vector<int32_t> keys;
+    };
+
+    std::vector<Run> runs_;
+    size_t rows_ = 0;
+};
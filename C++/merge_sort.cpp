@@ -1,30 +1,108 @@
 #include <iostream>    
 #include <fstream>    
-#include <sstream>     
 #include <vector>      
 #include <string>      
 #include <chrono>  
 #include <iomanip>
-
+#include <unistd.h>
+#include "allocation_counter.hpp"
+#include "binary_dataset.hpp"
+#include "cli_options.hpp"
+#include "compact_record.hpp"
+#include "csv_writer.hpp"
+#include "external_merge_sort.hpp"
+#include "incremental_merge.hpp"
+#include "key_index_sort.hpp"
+#include "parallel_merge_sort.hpp"
+#include "perf_counters.hpp"
+#include "sort_search.hpp"
 
 using namespace std;
 using namespace std::chrono;
 
 class TestMergeSort {
 public:
-    void main() {
+    // Optional arguments:
+    //   --threads=N       CSV parser and parallel engine threads (default: one per core, 1 = serial)
+    //   --engine=NAME     classic   - merge sort the (int, string) records directly (default)
+    //                     keyindex  - merge sort packed (key, row) pairs, then move each row once
+    //                     buffered  - one scratch buffer allocated up front, merges ping-pong between the two
+    //                     parallel  - buffered merge sort with halves and large merges run on a thread pool
+    //                     adaptive  - natural runs merged by the powersort policy with galloping; O(n) on sorted input
+    //                     external  - out-of-core: sorted runs spilled to disk, then a k-way loser-tree merge
+    //   --cutoff=N        parallel: ranges up to N records sort sequentially (default 16384)
+    //   --merge-cutoff=N  parallel: minimum records per parallel merge piece (default 65536)
+    //   --memory-limit=MB external: memory budget for one run and for the merge buffers (default 1024)
+    //   --tmp-dir=DIR     external: where run files are written (default: current directory)
+    //   --record=NAME     pair    - (int, string_view) records, 24 bytes each (default)
+    //                     compact - 16-byte records with the word copied inline (see compact_record.hpp)
+    //   --perf            count cycles, instructions, cache misses and page faults while sorting
+    //   --base=FILE       incremental: the entered file is a delta of new rows; sort only the delta, then
+    //                     merge it with the sorted CSV FILE in one streaming pass into merge_sort_<total>.csv
+    //   --lsm=DIR         incremental: sort the delta and add it as a sorted run in DIR (an existing
+    //                     directory); runs of similar size are merged, binary_search --lsm queries them all
+    void main(int argc, char* argv[]) {
+        if (!option_threads(argc, argv, worker_threads)) {
+            cerr << "Error: Invalid thread count '" << option_value(argc, argv, "threads") << "'." << endl;
+            return;
+        }
+        string engine = option_value(argc, argv, "engine", "classic");
+        parallel_cutoff = static_cast<size_t>(option_number(argc, argv, "cutoff", 16384));
+        parallel_merge_cutoff = static_cast<size_t>(option_number(argc, argv, "merge-cutoff", 65536));
+        if (!is_known_engine(engine)) {
+            cerr << "Error: Unknown sort engine '" << engine << "'." << endl;
+            return;
+        }
+        memory_limit_mb = static_cast<size_t>(option_number(argc, argv, "memory-limit", 1024));
+        temp_dir = option_value(argc, argv, "tmp-dir", ".");
+        count_events = has_flag(argc, argv, "perf");
+        string record_layout;
+        if (!option_record_layout(argc, argv, record_layout))
+            return;
+        base_filename = option_value(argc, argv, "base", "");
+        lsm_directory = option_value(argc, argv, "lsm", "");
+        bool incremental = !base_filename.empty() || !lsm_directory.empty();
+        if (incremental && engine == "external") {
+            cerr << "Error: --base and --lsm sort the delta in memory; choose an in-memory engine." << endl;
+            return;
+        }
+        if (!base_filename.empty() && !lsm_directory.empty()) {
+            cerr << "Error: Use either --base or --lsm, not both." << endl;
+            return;
+        }
+        if (record_layout == "compact" && (engine == "external" || incremental)) {
+            cerr << "Error: --record=compact applies to in-memory sorts; it cannot be used with --engine=external, --base or --lsm." << endl;
+            return;
+        }
+        if (!lsm_directory.empty()) {
+            // Checked before the delta is loaded, so a bad path fails fast
+            lsm_runs = LsmRunSet(lsm_directory);
+            if (!lsm_runs.open()) {
+                cerr << "Error: The run directory '" << lsm_directory << "' was not found." << endl;
+                return;
+            }
+        }
+
         string input_filename;
         cout << "Enter CSV file name: ";  // Ask user to enter CSV file name
         cin >> input_filename;
 
-        // Check if file name ends with ".csv"
-        if (input_filename.size() < 4 || input_filename.substr(input_filename.size() - 4) != ".csv") {
+        // Check if file name ends with ".csv" (or ".bin" for a binary dataset)
+        if (!has_dataset_extension(input_filename)) {
             cerr << "Error: Please provide a valid CSV file." << endl; 
             return;  
         }
 
-        // Read data from CSV file into vector of pairs (int, string)
-        vector<pair<int, string>> data = read_data_from_csv(input_filename);
+        // The external engine streams the file instead of loading it whole
+        if (engine == "external") {
+            external_sort(input_filename);
+            return;
+        }
+
+        // Read data from CSV file into vector of (int, string) records
+        Dataset dataset;
+        read_data_from_csv(input_filename, dataset, worker_threads);
+        vector<Record>& data = dataset.rows;
 
         // Check if data was loaded successfully
         if (data.empty()) {
@@ -32,19 +110,60 @@ public:
             return; 
         }
 
-        // Record start time before sorting
+        // Incremental refresh: only the delta is sorted, then merged or added as a run
+        if (incremental) {
+            sort_delta(engine, data);
+            return;
+        }
+
+        // Compact layout: copy the rows into 16-byte records and sort those instead
+        if (record_layout == "compact") {
+            vector<CompactRecord> compact;
+            if (!compact_loaded_rows(data, compact, input_filename))
+                return;
+            sort_and_save(engine, compact);
+            return;
+        }
+        sort_and_save(engine, data);
+    }
+
+private:
+    unsigned worker_threads = 0;          // Parser and parallel engine threads (0 = one per core)
+    size_t parallel_cutoff = 16384;       // Sequential below this range size
+    size_t parallel_merge_cutoff = 65536; // Smallest piece of a parallel merge
+    size_t memory_limit_mb = 1024;        // External engine memory budget
+    string temp_dir = ".";                // External engine run files directory
+    bool count_events = false;            // --perf: read hardware counters around the sort
+    string base_filename;                 // --base: sorted CSV the delta is merged into
+    string lsm_directory;                 // --lsm: run directory the sorted delta is added to
+    LsmRunSet lsm_runs{""};               // Opened from lsm_directory before the delta is loaded
+
+    // Time the sort of the loaded rows (Record or CompactRecord), then write them out
+    template <typename Row>
+    void sort_and_save(const string& engine, vector<Row>& data) {
+        // Record start time and heap allocation count before sorting
+        PerfCounters counters;
+        if (count_events)
+            counters.open();
+        size_t allocations_before = heap_allocation_count().load();
+        counters.start();
         auto start_time = high_resolution_clock::now();
         
-        // Perform merge sort on data vector
-        mergeSort(data);
+        // Perform merge sort on data vector with the selected engine
+        sort_data(engine, data);
         
-        // Record end time after sorting
+        // Record end time and allocation count after sorting
         auto end_time = high_resolution_clock::now();
+        counters.stop();
+        size_t allocations = heap_allocation_count().load() - allocations_before;
 
         // Calculate duration in milliseconds
         duration<double, milli> duration = end_time - start_time;
         cout << fixed << setprecision(3);
         cout << "Running time: " << duration.count() << " ms" << endl;  // Print running time with 3 decimal places
+        cout << "Heap allocations: " << allocations << endl;             // Allocations made while sorting
+        if (count_events)
+            counters.print(cout);
         
         // Create output filename based on data size
         string output_filename = "merge_sort_" + to_string(data.size()) + ".csv";
@@ -54,132 +173,173 @@ public:
         cout << "Sorted data written to " << output_filename << endl;  // Notify user
     }
 
-private:
-    // Function to read data from CSV file and return vector of (int, string) pairs
-    vector<pair<int, string>> read_data_from_csv(const string& filename) {
-        vector<pair<int, string>> data;  // Vector to store data
-        ifstream file(filename);         // Open file for reading
-        string line;                     // To store each line
+    // Sort the delta rows, then merge them into the base file or add them to
+    // the run directory; the timing covers both steps
+    void sort_delta(const string& engine, vector<Record>& delta) {
+        PerfCounters counters;
+        if (count_events)
+            counters.open();
+        counters.start();
+        auto start_time = high_resolution_clock::now();
 
-        // Check if file opened successfully
-        if (!file.is_open()) {
-            cerr << "Error: File '" << filename << "' not found." << endl;  
-            return data;  
-        }
-
-        // Read each line of the file
-        while (getline(file, line)) {
-            stringstream ss(line);       // Create string stream from line
-            string num_str, word;        // Variables to hold split parts
-            // Split line by comma into number string and word
-            if (getline(ss, num_str, ',') && getline(ss, word)) {
-                try {
-                    int number = stoi(num_str);        // Convert number string to int
-                    data.emplace_back(number, word);   // Add pair to data vector
-                } catch (...) {
-                    cerr << "Skipping row due to non-integer value: " << line << endl; 
-                }
-            } else {
-                cerr << "Skipping malformed row: " << line << endl;  
+        sort_data(engine, delta);
+
+        string error, output_filename;
+        size_t base_rows = 0, merges = 0;
+        if (!base_filename.empty()) {
+            // The total is only known once the base has been read, so merge into a temporary name
+            string temp_filename = "merge_sort_incremental_" + to_string(getpid()) + ".csv.tmp";
+            if (!merge_sorted_delta(base_filename, delta, temp_filename, base_rows, error)) {
+                remove(temp_filename.c_str());
+                cerr << "Error: " << error << endl;
+                return;
+            }
+            output_filename = "merge_sort_" + to_string(base_rows + delta.size()) + ".csv";
+            if (rename(temp_filename.c_str(), output_filename.c_str()) != 0) {
+                cerr << "An error occurred while writing the CSV: " << output_filename << endl;
+                return;
+            }
+        } else {
+            if (!lsm_runs.add_run(delta, merges, error)) {
+                cerr << "Error: " << error << endl;
+                return;
             }
         }
+        auto end_time = high_resolution_clock::now();
+        counters.stop();
 
-        return data;  
+        duration<double, milli> duration = end_time - start_time;
+        cout << fixed << setprecision(3);
+        cout << "Running time: " << duration.count() << " ms" << endl;  // Delta sort and merge together
+        cout << "Delta records: " << delta.size() << endl;
+        if (count_events)
+            counters.print(cout);
+        if (!base_filename.empty()) {
+            cout << "Base records: " << base_rows << endl;
+            cout << "Sorted data written to " << output_filename << endl;
+        } else {
+            cout << "Sorted runs: " << lsm_runs.runs().size() << " (" << merges << " merges)" << endl;
+            cout << "Runs written to " << lsm_directory << endl;
+        }
     }
 
-    // Function to write sorted data to CSV file
-    void write_data_to_csv(const vector<pair<int, string>>& data, const string& filename) {
-        ofstream file(filename);   
+    // Names accepted by --engine
+    bool is_known_engine(const string& engine) {
+        return engine == "classic" || engine == "keyindex" || engine == "buffered" || engine == "parallel" ||
+               engine == "adaptive" || engine == "external";
+    }
 
-        // Check if file opened successfully
-        if (!file.is_open()) {
-            cerr << "An error occurred while writing the CSV: " << filename << endl;  // Error on failure
+    // Sort the records with the chosen engine; every engine gives the same stable order
+    template <typename Row>
+    void sort_data(const string& engine, vector<Row>& data) {
+        if (engine == "keyindex")
+            sort_by_key_index(data, [](vector<KeyIndex>& keys) { merge_sort(keys.begin(), keys.end()); });
+        else if (engine == "buffered")
+            buffered_merge_sort(data.begin(), data.end());
+        else if (engine == "adaptive")
+            adaptive_merge_sort(data.begin(), data.end());
+        else if (engine == "parallel") {
+            ThreadPool pool(worker_threads);
+            ParallelMergeSort<Row>(pool, parallel_cutoff, parallel_merge_cutoff).sort(data);
+        }
+        else
+            merge_sort(data.begin(), data.end());
+    }
+
+    // Sort a file that may be larger than memory: spill sorted runs of at most
+    // memory_limit_mb, then merge them straight into the output CSV
+    void external_sort(const string& input_filename) {
+        if (input_filename.substr(input_filename.size() - 4) == ".bin") {
+            cerr << "Error: The external engine streams CSV text; please provide the .csv file." << endl;
             return;
         }
 
-        // Write each pair as "int,string" line to file
-        for (const auto& item : data) {
-            file << item.first << "," << item.second << "\n";
+        PerfCounters counters;
+        if (count_events)
+            counters.open();
+        counters.start();
+        auto start_time = high_resolution_clock::now();
+
+        ExternalMergeSort sorter(memory_limit_mb << 20, temp_dir);
+        bool opened = false;
+        size_t rows = sorter.create_runs(input_filename, opened, [](RowError error, size_t, string_view line) {
+            if (error == RowError::NonInteger)
+                cerr << "Skipping row due to non-integer value: " << line << endl;
+            else
+                cerr << "Skipping malformed row: " << line << endl;
+        }, [](vector<Record>& run) { buffered_merge_sort(run.begin(), run.end()); });
+
+        if (!opened) {
+            cerr << "Error: File '" << input_filename << "' not found." << endl;
+            cerr << "Error: Could not read data from " << input_filename << endl;
+            return;
         }
-        file.close(); 
-    }
+        if (sorter.failed()) {
+            cerr << "An error occurred while writing sorted runs to " << temp_dir << endl;
+            return;
+        }
+        if (rows == 0) {
+            cerr << "Error: Could not read data from " << input_filename << endl;
+            return;
+        }
+
+        // Create output filename based on data size, then merge the runs into it
+        string output_filename = "merge_sort_" + to_string(rows) + ".csv";
+        size_t runs = sorter.run_count();
+        if (!sorter.merge_runs(output_filename)) {
+            cerr << "An error occurred while writing the CSV: " << output_filename << endl;
+            return;
+        }
+        auto end_time = high_resolution_clock::now();
+        counters.stop();
 
-    // Public interface for merge sort; calls internal recursive _mergeSort if size > 1
-    void mergeSort(vector<pair<int, string>>& S) {
-        if (S.size() > 1)
-            _mergeSort(S, 0, S.size() - 1);  // Sort entire vector range
+        duration<double, milli> duration = end_time - start_time;
+        cout << fixed << setprecision(3);
+        cout << "Running time: " << duration.count() << " ms" << endl;  // Runs, spills and merge together
+        cout << "Sorted runs: " << runs << endl;
+        if (count_events)
+            counters.print(cout);
+        cout << "Sorted data written to " << output_filename << endl;
     }
 
-    // Recursive merge sort helper function
-    void _mergeSort(vector<pair<int, string>>& S, int left, int right) {
-        if (left < right) {
-            int mid = (left + right) / 2;  // Calculate middle index
-            _mergeSort(S, left, mid);       // Recursively sort left half
-            _mergeSort(S, mid + 1, right);  // Recursively sort right half
-            merge(S, left, mid, right);     // Merge sorted halves
-        }
+    // Function to memory-map the CSV file and parse it into (int, string) records
+    void read_data_from_csv(const string& filename, Dataset& dataset, unsigned threads) {
+        bool opened = load_dataset(filename, dataset, [](RowError error, size_t, string_view line) {
+            if (error == RowError::NonInteger)
+                cerr << "Skipping row due to non-integer value: " << line << endl;
+            else
+                cerr << "Skipping malformed row: " << line << endl;
+        }, threads);
+
+        // Check if file opened successfully
+        if (!opened)
+            cerr << "Error: File '" << filename << "' not found." << endl;
     }
 
-    // Merge two sorted subarrays of S back into S
-    void merge(vector<pair<int, string>>& S, int left, int mid, int right) {
-        int leftSize = mid - left + 1;   // Size of left subarray
-        int rightSize = right - mid;     // Size of right subarray
-
-        // Temporary vectors to hold the subarrays
-        vector<pair<int, string>> L(leftSize);
-        vector<pair<int, string>> R(rightSize);
-
-        // Copy left half into L
-        // part of the merge step in merge sort.
-        // It works by copying elements from the original array S, starting at index left, 
-        // into the temporary array L. The loop runs n1 times, 
-        // so it copies all elements from S[left] up to S[mid] into L[0] up to L[n1-1].
-        for (int i = 0; i < leftSize; ++i)
-            L[i] = S[left + i];
-
-        // Copy right half into R
-        //This line copies elements from the right half of the array S (from index mid + 1 to right) into the temporary array R. 
-        // The loop runs n2 times, so it fills R[0] to R[n2-1] with the elements S[mid + 1] to S[right].
-        for (int j = 0; j < rightSize; ++j)
-            R[j] = S[mid + 1 + j];
-
-        //i is used to track the current position in the left temporary array (L).
-        //j is used to track the current position in the right temporary array (R).
-        //k = left: index for placing merged elements back into the original array S, starting at the left boundary. 
-        // These variables help merge the two sorted halves back into S in the correct order.
-        int i = 0, j = 0, k = left;
-
-        // Merge elements back into S by comparing L and R
-        while (i < leftSize && j < rightSize) { // Continue while both subarrays have elements left
-            if (L[i].first <= R[j].first) {     // If current element in left subarray is less than or equal to right
-                S[k++] = L[i++];                // Copy element from left subarray to S and move to next in left
-            } else {
-                S[k++] = R[j++];                // Otherwise, copy element from right subarray to S and move to next in right
-            }
-        }
+    // Function to write sorted data to CSV file; formatting overlaps the writes
+    // unless the run is serial (--threads=1)
+    template <typename Row>
+    void write_data_to_csv(const vector<Row>& data, const string& filename) {
+        CsvBlockWriter file(filename, 8 << 20, worker_threads != 1);
 
-        // Copy any remaining elements from left half
-        //This line copies any remaining elements from the left temporary array L into the original array S. 
-        // It runs after the main merge loop, in case there are still elements left in L (because all elements in R have already been merged). 
-        // For each remaining element, it assigns L[i] to S[k], 
-        // then increments both i and k to move to the next positions.
-        while (i < leftSize) {
-            S[k++] = L[i++];
+        // Check if file opened successfully
+        if (!file.is_open()) {
+            cerr << "An error occurred while writing the CSV: " << filename << endl;  // Error on failure
+            return;
         }
 
-        // Copy any remaining elements from right half
-        //This line copies any remaining elements from the right temporary array R into the original array S. 
-        // It runs after the main merge loop, in case there are still elements left in R (because all elements in L have already been merged). 
-        // For each remaining element, it assigns R[j] to S[k], 
-        // then increments both j and k to move to the next positions.
-        while (j < rightSize) {
-            S[k++] = R[j++];
+        // Write each pair as "int,string" line to file
+        for (const auto& item : data) {
+            file.write_record(item.first, record_word(item));
         }
+        file.flush();
+        if (!file.good())
+            cerr << "An error occurred while writing the CSV: " << filename << endl;
     }
 };
 
-int main() {
+int main(int argc, char* argv[]) {
     TestMergeSort sorter;
-    sorter.main();         
+    sorter.main(argc, argv);         
     return 0;         
 }
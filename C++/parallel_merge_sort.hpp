@@ -0,0 +1,137 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include "thread_pool.hpp"
+
+// Parallel stable merge sort for pair-like elements ordered by .first.
+//
+// Like the buffered engine it ping-pongs between the input and one scratch
+// copy. The two recursive halves are forked onto a work-stealing pool until a
+// range drops below `cutoff`, and merges larger than `merge_cutoff` are split
+// with a co-ranking (merge path) search into independent pieces that merge in
+// parallel. Equal keys always take the left run first, so the result is the
+// unique stable order, identical to the sequential engines.
+template <typename T>
+class ParallelMergeSort {
+public:
+    ParallelMergeSort(ThreadPool& pool, size_t cutoff, size_t merge_cutoff)
+        : pool_(pool), cutoff_(std::max<size_t>(cutoff, 2)),
+          merge_cutoff_(std::max<size_t>(merge_cutoff, 2)) {}
+
+    void sort(std::vector<T>& S) {
+        if (S.size() < 2)
+            return;
+        std::vector<T> buffer(S);                  // Both copies start equal
+        sort_into(buffer, S, 0, S.size());
+    }
+
+private:
+    // Ranges at most this long are insertion sorted in place
+    static constexpr size_t kInsertionLimit = 16;
+
+    // Sort dst[lo, hi) using src[lo, hi) as scratch; both hold the same elements on entry
+    void sort_into(std::vector<T>& src, std::vector<T>& dst, size_t lo, size_t hi) {
+        if (hi - lo <= cutoff_) {
+            sequential_sort_into(src, dst, lo, hi);
+            return;
+        }
+        size_t mid = lo + (hi - lo) / 2;
+        {
+            TaskGroup halves(pool_);
+            halves.run([&, lo, mid]() { sort_into(dst, src, lo, mid); });  // Left half on the pool
+            sort_into(dst, src, mid, hi);                                   // Right half here
+            halves.wait();
+        }
+        parallel_merge(src, dst, lo, mid, hi);
+    }
+
+    void sequential_sort_into(std::vector<T>& src, std::vector<T>& dst, size_t lo, size_t hi) {
+        if (hi - lo <= kInsertionLimit) {
+            insertion_sort(dst, lo, hi);
+            return;
+        }
+        size_t mid = lo + (hi - lo) / 2;
+        sequential_sort_into(dst, src, lo, mid);
+        sequential_sort_into(dst, src, mid, hi);
+        merge_range(src.data() + lo, src.data() + mid, src.data() + mid, src.data() + hi, dst.data() + lo);
+    }
+
+    // Stable insertion sort of v[lo, hi)
+    static void insertion_sort(std::vector<T>& v, size_t lo, size_t hi) {
+        for (size_t i = lo + 1; i < hi; ++i) {
+            T item = std::move(v[i]);
+            size_t j = i;
+            while (j > lo && v[j - 1].first > item.first) {
+                v[j] = std::move(v[j - 1]);
+                --j;
+            }
+            v[j] = std::move(item);
+        }
+    }
+
+    // Merge [a, a_end) and [b, b_end) into out, taking from a on ties
+    static void merge_range(T* a, T* a_end, T* b, T* b_end, T* out) {
+        while (a != a_end && b != b_end) {
+            if (a->first <= b->first)
+                *out++ = std::move(*a++);
+            else
+                *out++ = std::move(*b++);
+        }
+        out = std::move(a, a_end, out);
+        std::move(b, b_end, out);
+    }
+
+    // Number of elements of A among the first k outputs of the stable merge of A and B
+    static size_t co_rank(size_t k, const T* A, size_t m, const T* B, size_t n) {
+        size_t i = std::min(k, m);
+        size_t j = k - i;
+        size_t i_low = k > n ? k - n : 0;
+        size_t j_low = k > m ? k - m : 0;
+        for (;;) {
+            if (i > 0 && j < n && A[i - 1].first > B[j].first) {
+                size_t delta = (i - i_low + 1) / 2;     // Took too many from A
+                j_low = j;
+                i -= delta;
+                j += delta;
+            } else if (j > 0 && i < m && B[j - 1].first >= A[i].first) {
+                size_t delta = (j - j_low + 1) / 2;     // Took too many from B
+                i_low = i;
+                i += delta;
+                j -= delta;
+            } else {
+                return i;
+            }
+        }
+    }
+
+    // Merge src[lo, mid) and src[mid, hi) into dst[lo, hi), split into
+    // equal-sized output pieces so each worker merges one independently
+    void parallel_merge(std::vector<T>& src, std::vector<T>& dst, size_t lo, size_t mid, size_t hi) {
+        T* A = src.data() + lo;
+        T* B = src.data() + mid;
+        size_t m = mid - lo, n = hi - mid, total = hi - lo;
+        size_t pieces = std::min<size_t>(pool_.size(), total / merge_cutoff_);
+        if (pieces <= 1) {
+            merge_range(A, A + m, B, B + n, dst.data() + lo);
+            return;
+        }
+
+        TaskGroup group(pool_);
+        for (size_t p = 0; p < pieces; ++p) {
+            group.run([=, &dst]() {
+                size_t k0 = total * p / pieces, k1 = total * (p + 1) / pieces;
+                size_t i0 = co_rank(k0, A, m, B, n), i1 = co_rank(k1, A, m, B, n);
+                merge_range(A + i0, A + i1, B + (k0 - i0), B + (k1 - i1), dst.data() + lo + k0);
+            });
+        }
+        group.wait();
+    }
+
+    ThreadPool& pool_;
+    size_t cutoff_;        // Ranges up to this size sort sequentially
+    size_t merge_cutoff_;  // Minimum output elements per parallel merge piece
+};
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <vector>
+
+#include "radix_sort.hpp"
+#include "thread_pool.hpp"
+
+// Wall-clock time spent in each phase of ParallelRadixSort, in milliseconds
+struct RadixPhaseTimes {
+    double histogram_ms = 0;
+    double scatter_ms = 0;
+    double local_sort_ms = 0;
+};
+
+// Parallel MSD radix sort for pair-like elements keyed by an int .first.
+//
+// 1. Histogram: the input is cut into one contiguous chunk per worker and
+//    each worker counts the top digit (bits 22-31) of its own chunk.
+// 2. Scatter:   bucket starts are prefix-summed in (bucket, chunk) order, so
+//    every worker writes its chunk into disjoint slots, keeping input order
+//    within a bucket.
+// 3. Local sort: each bucket is LSD radix sorted on the remaining 22 bits as
+//    an independent pool task.
+// Every step is stable, so the result equals merge sort's order.
+template <typename T>
+class ParallelRadixSort {
+public:
+    explicit ParallelRadixSort(ThreadPool& pool) : pool_(pool) {}
+
+    void sort(std::vector<T>& v) {
+        const size_t n = v.size();
+        if (n < 2)
+            return;
+
+        using clock = std::chrono::high_resolution_clock;
+        const int top = kRadixPasses - 1;                 // Digit used to split into buckets
+        const size_t chunks = std::max<size_t>(1, std::min<size_t>(pool_.size(), n / kMinChunk));
+        std::vector<T> buffer(n);
+
+        // 1. Per-chunk histograms of the top digit
+        auto t0 = clock::now();
+        std::vector<size_t> counts(chunks * kRadixBuckets, 0);
+        for_each_chunk(chunks, n, [&](size_t c, size_t lo, size_t hi) {
+            size_t* count = &counts[c * kRadixBuckets];
+            for (size_t i = lo; i < hi; ++i)
+                ++count[radix_digit(radix_key(v[i].first), top)];
+        });
+
+        // Bucket b of chunk c starts after all smaller buckets and after
+        // bucket b of the earlier chunks
+        std::vector<size_t> bucket_start(kRadixBuckets + 1, 0);
+        size_t sum = 0;
+        for (size_t b = 0; b < kRadixBuckets; ++b) {
+            bucket_start[b] = sum;
+            for (size_t c = 0; c < chunks; ++c) {
+                size_t count = counts[c * kRadixBuckets + b];
+                counts[c * kRadixBuckets + b] = sum;
+                sum += count;
+            }
+        }
+        bucket_start[kRadixBuckets] = n;
+
+        // 2. Scatter each chunk into its reserved slots
+        auto t1 = clock::now();
+        for_each_chunk(chunks, n, [&](size_t c, size_t lo, size_t hi) {
+            size_t* next = &counts[c * kRadixBuckets];
+            for (size_t i = lo; i < hi; ++i)
+                buffer[next[radix_digit(radix_key(v[i].first), top)]++] = std::move(v[i]);
+        });
+
+        // 3. Sort every bucket on the lower digits; v is free to use as scratch.
+        //    Results are brought back into buffer, which then becomes v.
+        auto t2 = clock::now();
+        {
+            TaskGroup group(pool_);
+            for (size_t b = 0; b < kRadixBuckets; ++b) {
+                size_t lo = bucket_start[b], hi = bucket_start[b + 1];
+                if (hi - lo < 2)
+                    continue;
+                group.run([&, lo, hi]() {
+                    T* sorted = lsd_radix_sort_span(buffer.data() + lo, v.data() + lo, hi - lo, top);
+                    if (sorted != buffer.data() + lo)
+                        std::move(sorted, sorted + (hi - lo), buffer.data() + lo);
+                });
+            }
+            group.wait();
+        }
+        v.swap(buffer);
+        auto t3 = clock::now();
+
+        times_.histogram_ms = std::chrono::duration<double, std::milli>(t1 - t0).count();
+        times_.scatter_ms = std::chrono::duration<double, std::milli>(t2 - t1).count();
+        times_.local_sort_ms = std::chrono::duration<double, std::milli>(t3 - t2).count();
+    }
+
+    const RadixPhaseTimes& phase_times() const { return times_; }
+
+private:
+    // Chunks smaller than this are not worth a separate task
+    static constexpr size_t kMinChunk = 1 << 16;
+
+    // Run body(chunk, lo, hi) for `chunks` equal slices of [0, n) in parallel
+    template <typename Body>
+    void for_each_chunk(size_t chunks, size_t n, Body body) {
+        TaskGroup group(pool_);
+        for (size_t c = 0; c < chunks; ++c)
+            group.run([&body, c, chunks, n]() { body(c, n * c / chunks, n * (c + 1) / chunks); });
+        group.wait();
+    }
+
+    ThreadPool& pool_;
+    RadixPhaseTimes times_;
+};
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <string>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// Hardware and software event counters around a phase of work, via Linux
+// perf_event_open. Counters follow the calling thread and every thread it
+// starts afterwards (so pools built inside the phase are included), and
+// count user space only, which perf_event_paranoid 2 still allows.
+//
+// Containers and VMs often refuse some or all events. Each counter is opened
+// on its own, so the ones that work are still reported, and if none do the
+// tools print why and carry on.
+class PerfCounters {
+public:
+    static constexpr int kEvents = 6;
+
+    PerfCounters() {
+        for (int i = 0; i < kEvents; ++i)
+            fds_[i] = -1;
+    }
+
+    ~PerfCounters() {
+        for (int fd : fds_)
+            if (fd >= 0)
+                close(fd);
+    }
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    // Open every counter; false if none could be opened. error() says why the
+    // first one that failed was refused.
+    bool open() {
+#ifdef __linux__
+        const Event events[kEvents] = {
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+            {PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                     (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)},
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},   // Last-level cache
+            {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS},
+        };
+        int first_errno = 0;
+        for (int i = 0; i < kEvents; ++i) {
+            perf_event_attr attr;
+            memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = events[i].type;
+            attr.config = events[i].config;
+            attr.disabled = 1;
+            attr.inherit = 1;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+            fds_[i] = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+            if (fds_[i] < 0 && first_errno == 0)
+                first_errno = errno;
+        }
+        if (first_errno != 0)
+            error_ = std::string("perf_event_open: ") + strerror(first_errno);
+        if (available())
+            return true;
+#else
+        error_ = "perf_event_open needs Linux";
+#endif
+        return false;
+    }
+
+    bool available() const {
+        for (int fd : fds_)
+            if (fd >= 0)
+                return true;
+        return false;
+    }
+
+    const std::string& error() const { return error_; }
+
+    // Zero the counters and start counting
+    void start() {
+#ifdef __linux__
+        for (int fd : fds_) {
+            if (fd >= 0) {
+                ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+                ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+            }
+        }
+#endif
+    }
+
+    // Stop counting and read the totals, scaled up if the kernel had to
+    // share the hardware counters between events (multiplexing)
+    void stop() {
+#ifdef __linux__
+        for (int i = 0; i < kEvents; ++i) {
+            values_[i] = -1;
+            if (fds_[i] < 0)
+                continue;
+            ioctl(fds_[i], PERF_EVENT_IOC_DISABLE, 0);
+            uint64_t data[3];   // value, time enabled, time running
+            if (read(fds_[i], data, sizeof(data)) != sizeof(data))
+                continue;
+            double value = static_cast<double>(data[0]);
+            if (data[2] > 0 && data[2] < data[1])
+                value *= static_cast<double>(data[1]) / data[2];
+            values_[i] = static_cast<long long>(value);
+        }
+#endif
+    }
+
+    // The last start()..stop() totals, one "Name: value" line each, or the
+    // reason the counters are unavailable
+    void print(std::ostream& out) const {
+        if (!available()) {
+            out << "Perf counters: unavailable (" << error_ << ")\n";
+            return;
+        }
+        static const char* const kNames[kEvents] = {"Cycles", "Instructions", "Branch misses",
+                                                    "L1D read misses", "LLC misses", "Page faults"};
+        for (int i = 0; i < kEvents; ++i) {
+            out << kNames[i] << ": ";
+            if (values_[i] < 0)
+                out << "n/a";
+            else
+                out << values_[i];
+            if (i == 1 && values_[0] > 0 && values_[1] >= 0)
+                out << " (IPC " << static_cast<double>(values_[1]) / values_[0] << ")";
+            out << "\n";
+        }
+        if (!error_.empty())
+            out << "Perf counters: n/a events unavailable (" << error_ << ")\n";
+    }
+
+private:
+    struct Event {
+        uint32_t type;
+        uint64_t config;
+    };
+
+    int fds_[kEvents];
+    long long values_[kEvents] = {-1, -1, -1, -1, -1, -1};
+    std::string error_;
+};
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Search strategies over a packed, ascending int32 key column that use the
+// key values to decide where to look, not just the range bounds. All of them
+// compute lower_bound: the first index whose key is not less than the target
+// (n if there is none).
+//
+// Each search calls probe() once for every key it reads, so the same code
+// is timed with NoProbeCount (which compiles away) and measured with
+// ProbeCount.
+
+struct NoProbeCount {
+    void operator()() const {}
+};
+
+struct ProbeCount {
+    size_t probes = 0;
+    void operator()() { ++probes; }
+};
+
+// Ranges this small are finished by a linear scan in the hybrid search
+constexpr size_t kSequentialScanLimit = 16;
+
+// Position in [lo, hi) where target would sit if keys rose linearly from
+// `low` at lo to `high` at hi - 1; requires low < target <= high
+inline size_t interpolate(size_t lo, size_t hi, int64_t low, int64_t high, int64_t target) {
+    double fraction = static_cast<double>(target - low) / static_cast<double>(high - low);
+    size_t pos = lo + static_cast<size_t>(fraction * static_cast<double>(hi - 1 - lo));
+    return pos < hi ? pos : hi - 1;
+}
+
+// Interpolation steps a search may take before it falls back to bisection.
+// Uniform keys rarely need more than log2(log2 n) + 2 of them; skewed keys,
+// or a long run of one duplicate key, can shrink the range by a single key
+// per step, and the fallback keeps those searches O(log n) instead of O(n).
+constexpr int kInterpolationSteps = 8;
+
+// One step of the search on keys[lo, hi), where keys[lo] < target <= keys[hi - 1]
+template <typename Probe>
+void interpolation_step(const int32_t* keys, int32_t target, size_t& lo, size_t& hi, int& steps_left, Probe& probe) {
+    size_t pos = (steps_left-- > 0) ? interpolate(lo, hi, keys[lo], keys[hi - 1], target) : lo + (hi - lo) / 2;
+    probe();
+    if (keys[pos] < target)
+        lo = pos + 1;
+    else
+        hi = pos;
+}
+
+// Interpolation search: about log2(log2 n) probes on uniform keys
+template <typename Probe>
+size_t interpolation_lower_bound(const int32_t* keys, size_t n, int32_t target, Probe& probe) {
+    size_t lo = 0, hi = n;   // keys[lo - 1] < target <= keys[hi]
+    int steps_left = kInterpolationSteps;
+    while (lo < hi) {
+        probe();
+        if (target <= keys[lo])
+            return lo;
+        probe();
+        if (target > keys[hi - 1])
+            return hi;
+        interpolation_step(keys, target, lo, hi, steps_left, probe);
+    }
+    return lo;
+}
+
+// Interpolation until the range holds kSequentialScanLimit keys or fewer,
+// then a forward scan, which reads one or two cache lines instead of making
+// more scattered probes
+template <typename Probe>
+size_t interpolation_sequential_lower_bound(const int32_t* keys, size_t n, int32_t target, Probe& probe) {
+    size_t lo = 0, hi = n;
+    int steps_left = kInterpolationSteps;
+    while (hi - lo > kSequentialScanLimit) {
+        probe();
+        if (target <= keys[lo])
+            return lo;
+        probe();
+        if (target > keys[hi - 1])
+            return hi;
+        interpolation_step(keys, target, lo, hi, steps_left, probe);
+    }
+    while (lo < hi) {
+        probe();
+        if (keys[lo] >= target)
+            break;
+        ++lo;
+    }
+    return lo;
+}
+
+// Exponential (galloping) search: doubles the bound from the front until it
+// passes the target, then bisects the last gap. Costs 2*log2(i) probes for an
+// answer at index i, so targets near the front are found fastest.
+template <typename Probe>
+size_t exponential_lower_bound(const int32_t* keys, size_t n, int32_t target, Probe& probe) {
+    if (n == 0)
+        return 0;
+    probe();
+    if (keys[0] >= target)
+        return 0;
+    size_t bound = 1;
+    while (bound < n) {
+        probe();
+        if (keys[bound] >= target)
+            break;
+        bound *= 2;
+    }
+    size_t lo = bound / 2 + 1, hi = bound < n ? bound : n;   // keys[lo - 1] < target
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        probe();
+        if (keys[mid] < target)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
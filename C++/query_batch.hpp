@@ -0,0 +1,128 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "binary_dataset.hpp"
+#include "key_index_sort.hpp"
+#include "key_search.hpp"
+#include "probe_search.hpp"
+#include "thread_pool.hpp"
+
+// Batch lookups of many targets against a sorted key column. A block of
+// queries is sorted first (each keeps its position in the block), so the
+// answers walk the keys front to back instead of jumping around:
+//   coscan   - one merge-style pass, galloping from the previous answer;
+//              O(m log(n/m)) for m queries and every probe is near the last
+//   parallel - the sorted queries are cut into one slice per worker and
+//              each slice runs the lockstep batch kernel
+// Answers are row indices in the sorted dataset, -1 for a missing target.
+
+// Load the targets of a query file: the key column of a binary dataset, or
+// the leading integer of every line of a text file ("int" or "int,word").
+// Lines without a valid integer go to on_bad_line(line_num, line) and are
+// skipped. Returns false if the file cannot be opened.
+template <typename OnBadLine>
+bool load_targets(const std::string& filename, std::vector<int32_t>& targets, OnBadLine on_bad_line) {
+    targets.clear();
+    Dataset queries;
+    if (!queries.file.open(filename))
+        return false;
+
+    if (is_binary_dataset(queries.file)) {
+        if (!read_binary_columns(queries)) {
+            std::cerr << "Error: '" << filename << "' is not a valid binary dataset." << std::endl;
+            return true;
+        }
+        targets.reserve(queries.rows.size());
+        for (const Record& row : queries.rows)
+            targets.push_back(row.first);
+        return true;
+    }
+
+    const char* p = queries.file.data();
+    const char* end = p + queries.file.size();
+    size_t line_num = 0;
+    while (p < end) {
+        const char* nl = static_cast<const char*>(memchr(p, '\n', end - p));
+        const char* line_end = nl ? nl : end;
+        ++line_num;
+        const char* comma = static_cast<const char*>(memchr(p, ',', line_end - p));
+        int target;
+        if (parse_int(p, comma ? comma : line_end, target))
+            targets.push_back(target);
+        else if (line_end > p && !(line_end - p == 1 && *p == '\r'))
+            on_bad_line(line_num, std::string_view(p, line_end - p));   // Blank lines are not errors
+        p = line_end + 1;
+    }
+    return true;
+}
+
+// Sort targets[0, count) by key, remembering each one's position
+inline void sort_queries(const int32_t* targets, size_t count, std::vector<KeyIndex>& sorted) {
+    sorted.resize(count);
+    for (size_t i = 0; i < count; ++i)
+        sorted[i] = KeyIndex(targets[i], static_cast<uint32_t>(i));
+    std::sort(sorted.begin(), sorted.end());
+}
+
+// Answer sorted queries in one pass over keys; rows[i] gets the answer of
+// the query that was at position i
+inline void coscan_queries(const int32_t* keys, size_t n, const std::vector<KeyIndex>& sorted,
+                           long long* rows) {
+    NoProbeCount probe;
+    size_t pos = 0;
+    for (const KeyIndex& query : sorted) {
+        pos += exponential_lower_bound(keys + pos, n - pos, query.first, probe);
+        rows[query.second] = (pos < n && keys[pos] == query.first) ? static_cast<long long>(pos) : -1;
+    }
+}
+
+// Answer sorted queries with the batch kernel, one contiguous slice per worker
+inline void parallel_queries(ThreadPool& pool, const int32_t* keys, size_t n,
+                             const std::vector<KeyIndex>& sorted, long long* rows) {
+    const size_t count = sorted.size();
+    const size_t slices = std::max<size_t>(1, std::min<size_t>(pool.size(), count / kSearchLanes));
+    TaskGroup group(pool);
+    for (size_t s = 0; s < slices; ++s) {
+        size_t lo = count * s / slices, hi = count * (s + 1) / slices;
+        group.run([=, &sorted]() {
+            std::vector<int32_t> targets(hi - lo);
+            std::vector<size_t> positions(hi - lo);
+            for (size_t i = lo; i < hi; ++i)
+                targets[i - lo] = sorted[i].first;
+            batch_lower_bound(keys, n, targets.data(), targets.size(), positions.data());
+            for (size_t i = lo; i < hi; ++i) {
+                size_t pos = positions[i - lo];
+                rows[sorted[i].second] = (pos < n && keys[pos] == sorted[i].first) ? static_cast<long long>(pos) : -1;
+            }
+        });
+    }
+    group.wait();
+}
+
+// Per-query latency percentile when every query of a block waits for the
+// whole block; blocks holds (milliseconds, queries) for each block
+inline double latency_percentile(std::vector<std::pair<double, size_t>> blocks, double percentile) {
+    size_t total = 0;
+    for (const auto& block : blocks)
+        total += block.second;
+    if (total == 0)
+        return 0;
+    std::sort(blocks.begin(), blocks.end());
+    const double rank = percentile / 100.0 * total;
+    size_t seen = 0;
+    for (const auto& block : blocks) {
+        seen += block.second;
+        if (seen >= rank)
+            return block.first;
+    }
+    return blocks.back().first;
+}
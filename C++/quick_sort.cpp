@@ -1,10 +1,20 @@
 #include <iostream>      
 #include <fstream>        
-#include <sstream>        
 #include <vector>         
 #include <string>          
 #include <chrono>        
 #include <iomanip>         
+#include <algorithm>
+#include <functional>
+#include "cli_options.hpp"
+#include "binary_dataset.hpp"
+#include "compact_record.hpp"
+#include "csv_writer.hpp"
+#include "introsort.hpp"
+#include "key_index_sort.hpp"
+#include "perf_counters.hpp"
+#include "sort_search.hpp"
+#include "stream_select.hpp"
 
 using namespace std;       
 using namespace std::chrono; 
@@ -12,21 +22,74 @@ using namespace std::chrono;
 
 class TestQuickSort {
 public:
-    void main() {
+    // Optional arguments:
+    //   --threads=N       CSV parser and parallel engine threads (default: one per core, 1 = serial)
+    //   --engine=NAME     classic   - quick sort the (int, string) records directly (default)
+    //                     keyindex  - quick sort packed (key, row) pairs, then move each row once
+    //                     introsort - ninther pivot, Hoare partition, heapsort fallback, parallel subranges
+    //   --cutoff=N        introsort: subranges over N records are forked onto the pool (default 16384)
+    //   --partition=NAME  classic/keyindex kernel: lomuto (default) or block (branchless, batched swaps)
+    //   --record=NAME     pair    - (int, string_view) records, 24 bytes each (default)
+    //                     compact - 16-byte records with the word copied inline (see compact_record.hpp)
+    //   --perf            count cycles, instructions, cache misses and page faults while sorting
+    //   --top=K           write only the K smallest records, in order, instead of sorting them all
+    //   --rank=LO,HI      write only the records at ranks LO..HI (0-based, inclusive) of the sorted order;
+    //                     --rank=K,K is the K-th smallest record
+    //   --largest         --top and --rank count down from the largest key (still written ascending)
+    //   --select=NAME     introselect - partial quick sort: only partitions overlapping the ranks are
+    //                                   followed, with --partition's kernel (default)
+    //                     heap        - one pass over the CSV with a bounded heap of the HI + 1 best rows;
+    //                                   the file is never loaded as records (CSV input only)
+    void main(int argc, char* argv[]) {
+        if (!option_threads(argc, argv, worker_threads)) {
+            cerr << "Error: Invalid thread count '" << option_value(argc, argv, "threads") << "'." << endl;
+            return;
+        }
+        string engine = option_value(argc, argv, "engine", "classic");
+        parallel_cutoff = static_cast<size_t>(option_number(argc, argv, "cutoff", 16384));
+        string kernel = option_value(argc, argv, "partition", "lomuto");
+        if (kernel != "lomuto" && kernel != "block") {
+            cerr << "Error: Unknown partition kernel '" << kernel << "'." << endl;
+            return;
+        }
+        use_block_partition = (kernel == "block");
+        count_events = has_flag(argc, argv, "perf");
+        string record_layout;
+        if (!option_record_layout(argc, argv, record_layout))
+            return;
+        if (!is_known_engine(engine)) {
+            cerr << "Error: Unknown sort engine '" << engine << "'." << endl;
+            return;
+        }
+        if (!parse_selection(argc, argv))
+            return;
+        if (record_layout == "compact" && selecting && select_engine == "heap") {
+            cerr << "Error: --record=compact cannot be used with --select=heap, which never loads the records." << endl;
+            return;
+        }
+
         string input_filename;
 
         // Ask user for the CSV file name
         cout << "Enter CSV file name: ";
         cin >> input_filename;
 
-        // Check if the input file has the '.csv' extension
-        if (input_filename.substr(input_filename.find_last_of('.') + 1) != "csv") {
-            cerr << "Error: Invalid file type. Please provide a valid CSV file ending with '.csv'." << endl;
+        // Check if the input file has the '.csv' (or binary '.bin') extension
+        if (!has_dataset_extension(input_filename)) {
+            cerr << "Error: Invalid file type. Please provide a valid CSV file ending with '.csv' or a dataset ending with '.bin'." << endl;
             return; 
         }
 
-        // Load data from CSV into a vector of integer-string pairs
-        vector<pair<int, string>> records = load_csv_data(input_filename);
+        // The heap selector streams the file itself
+        if (selecting && select_engine == "heap") {
+            stream_select(input_filename);
+            return;
+        }
+
+        // Load data from CSV into a vector of integer-string records
+        Dataset dataset;
+        load_csv_data(input_filename, dataset, worker_threads);
+        vector<Record>& records = dataset.rows;
 
         // If data loading failed, display error and exit
         if (records.empty()) {
@@ -34,19 +97,206 @@ public:
             return;
         }
 
+        // Compact layout: copy the rows into 16-byte records and sort those instead
+        if (record_layout == "compact") {
+            vector<CompactRecord> compact;
+            if (!compact_loaded_rows(records, compact, input_filename))
+                return;
+            if (selecting)
+                select_and_save(compact);
+            else
+                sort_and_save(engine, compact);
+            return;
+        }
+        if (selecting)
+            select_and_save(records);
+        else
+            sort_and_save(engine, records);
+    }
+
+private:
+    unsigned worker_threads = 0;     // Parser and parallel engine threads (0 = one per core)
+    size_t parallel_cutoff = 16384;  // Introsort forks subranges larger than this
+    bool use_block_partition = false; // Classic kernel: BlockPartition instead of LomutoPartition
+    bool count_events = false;       // --perf: read hardware counters around the sort
+    bool selecting = false;          // --top or --rank: select ranks [select_lo, select_hi) only
+    size_t select_lo = 0, select_hi = 0;
+    bool select_largest = false;     // --largest: ranks count down from the largest key
+    string select_engine = "introselect";
+
+    // Read --top, --rank, --largest and --select; false (after an error) if invalid
+    bool parse_selection(int argc, char* argv[]) {
+        string top = option_value(argc, argv, "top", "");
+        string rank = option_value(argc, argv, "rank", "");
+        select_largest = has_flag(argc, argv, "largest");
+        select_engine = option_value(argc, argv, "select", "introselect");
+        if (select_engine != "introselect" && select_engine != "heap") {
+            cerr << "Error: Unknown selection engine '" << select_engine << "'." << endl;
+            return false;
+        }
+        if (!top.empty() && !rank.empty()) {
+            cerr << "Error: Use either --top or --rank, not both." << endl;
+            return false;
+        }
+        int bounds[2] = {0, 0};
+        if (!top.empty()) {
+            if (!parse_option_int(top, bounds[1]) || bounds[1] < 1) {
+                cerr << "Error: Invalid record count '" << top << "' for --top." << endl;
+                return false;
+            }
+            bounds[1] -= 1;
+        } else if (!rank.empty()) {
+            vector<string> parts = option_list(argc, argv, "rank");
+            if (parts.size() != 2 || !parse_option_int(parts[0], bounds[0]) || !parse_option_int(parts[1], bounds[1]) ||
+                bounds[0] < 0 || bounds[1] < bounds[0]) {
+                cerr << "Error: Invalid rank range '" << rank << "', expected LO,HI with 0 <= LO <= HI." << endl;
+                return false;
+            }
+        } else {
+            return true;
+        }
+        selecting = true;
+        select_lo = static_cast<size_t>(bounds[0]);
+        select_hi = static_cast<size_t>(bounds[1]) + 1;
+        return true;
+    }
+
+    // Time the selection of the wanted ranks from the loaded records, then write only those
+    template <typename Row>
+    void select_and_save(vector<Row>& records) {
+        if (select_lo >= records.size()) {
+            cerr << "Error: Rank " << select_lo << " is beyond the " << records.size() << " records." << endl;
+            return;
+        }
+        size_t hi = min(select_hi, records.size());
+
+        PerfCounters counters;
+        if (count_events)
+            counters.open();
+        counters.start();
+        auto start = high_resolution_clock::now();
+
+        // Partition only towards the wanted ranks; --largest ranks by descending key
+        if (select_largest)
+            select_ranks(records, select_lo, hi, greater<>());
+        else
+            select_ranks(records, select_lo, hi, less<>());
+
+        auto end = high_resolution_clock::now();
+        counters.stop();
+
+        vector<Row> selected(records.begin() + select_lo, records.begin() + hi);
+        if (select_largest)
+            reverse(selected.begin(), selected.end());
+        duration<double, milli> duration = end - start;
+        report_selection(duration.count(), counters, selected, records.size());
+    }
+
+    // Move ranks [lo, hi) under less into place: introselect for a single
+    // rank, otherwise a partial quick sort, both with the --partition kernel
+    template <typename Row, typename Less>
+    void select_ranks(vector<Row>& records, size_t lo, size_t hi, Less less) {
+        auto first = records.begin();
+        if (hi - lo == 1) {
+            if (use_block_partition)
+                quick_select<BlockPartition>(first, first + lo, records.end(), FirstKey(), less);
+            else
+                quick_select<LomutoPartition>(first, first + lo, records.end(), FirstKey(), less);
+        } else {
+            if (use_block_partition)
+                partial_quick_sort<BlockPartition>(first, first + lo, first + hi, records.end(), FirstKey(), less);
+            else
+                partial_quick_sort<LomutoPartition>(first, first + lo, first + hi, records.end(), FirstKey(), less);
+        }
+    }
+
+    // Select the wanted ranks in one streaming pass; the timing covers reading
+    // the file, since that pass is the whole job
+    void stream_select(const string& input_filename) {
+        if (input_filename.substr(input_filename.size() - 4) == ".bin") {
+            cerr << "Error: The heap selector streams CSV text; please provide the .csv file." << endl;
+            return;
+        }
+
+        PerfCounters counters;
+        if (count_events)
+            counters.open();
+        counters.start();
+        auto start = high_resolution_clock::now();
+
+        Dataset dataset;
+        size_t rows = 0;
+        bool opened = StreamSelect(select_lo, select_hi, select_largest).run(input_filename, dataset, rows,
+            [](RowError error, size_t, string_view line) {
+                if (error == RowError::NonInteger)
+                    cerr << "Warning: Skipping row with invalid integer value: " << line << endl;
+                else
+                    cerr << "Warning: Skipping malformed row (expected 2 columns): " << line << endl;
+            });
+
+        auto end = high_resolution_clock::now();
+        counters.stop();
+
+        if (!opened) {
+            cerr << "Error: The file '" << input_filename << "' could not be found or opened." << endl;
+            return;
+        }
+        if (rows == 0) {
+            cerr << "Error: Failed to read data from the file '" << input_filename << "'. Please check the file and try again." << endl;
+            return;
+        }
+        if (select_lo >= rows) {
+            cerr << "Error: Rank " << select_lo << " is beyond the " << rows << " records." << endl;
+            return;
+        }
+        duration<double, milli> duration = end - start;
+        report_selection(duration.count(), counters, dataset.rows, rows);
+    }
+
+    // Print the timing and ranks, then write the selected rows to
+    // quick_select[_largest]_LO_HI.csv
+    template <typename Row>
+    void report_selection(double milliseconds, const PerfCounters& counters, const vector<Row>& selected,
+                          size_t total) {
+        size_t last_rank = select_lo + selected.size() - 1;
+        cout << fixed << setprecision(3);
+        cout << "Running time: " << milliseconds << " ms" << endl;
+        if (count_events)
+            counters.print(cout);
+        cout << "Selected ranks: " << select_lo << " to " << last_rank << " of " << total
+             << (select_largest ? " (from the largest key)" : "") << endl;
+
+        string output_filename = string("quick_select_") + (select_largest ? "largest_" : "") +
+                                 to_string(select_lo) + "_" + to_string(last_rank) + ".csv";
+        save_to_csv(selected, output_filename);
+        cout << "Sorted data has been saved to file: " << output_filename << endl;
+    }
+
+    // Time the sort of the loaded records (Record or CompactRecord), then write them out
+    template <typename Row>
+    void sort_and_save(const string& engine, vector<Row>& records) {
+        // Open the hardware counters before the clock starts, so opening them is not timed
+        PerfCounters counters;
+        if (count_events)
+            counters.open();
+
         // Start measuring the execution time for sorting
+        counters.start();
         auto start = high_resolution_clock::now();
 
-        // Sort the data using Quick Sort
-        quick_sort(records, 0, records.size() - 1);
+        // Sort the data using Quick Sort with the selected engine
+        sort_records(engine, records);
 
         // Stop measuring time after sorting is complete
         auto end = high_resolution_clock::now();
+        counters.stop();
 
         // Calculate the duration in milliseconds with high precision
         duration<double, milli> duration = end - start;
         cout << fixed << setprecision(3);
         cout << "Running time: " << duration.count() << " ms" << endl;
+        if (count_events)
+            counters.print(cout);
 
         // Construct output filename using the number of records
         string output_filename = "quick_sort_" + to_string(records.size()) + ".csv";
@@ -56,46 +306,59 @@ public:
         cout << "Sorted data has been saved to file: " << output_filename << endl;
     }
 
-private:
-    // Load CSV file data and return as a vector of integer-string pairs
-    vector<pair<int, string>> load_csv_data(const string& filename) {
-        vector<pair<int, string>> data;   // Vector to store parsed rows
-        ifstream file(filename);          // Open the file for reading
-        string line;                      // To store each line from file
+    // Names accepted by --engine
+    bool is_known_engine(const string& engine) {
+        return engine == "classic" || engine == "keyindex" || engine == "introsort";
+    }
 
-        // If the file couldn't be opened, show an error
-        if (!file.is_open()) {
-            cerr << "Error: The file '" << filename << "' could not be found or opened." << endl;
-            return data; 
+    // Sort the records with the chosen engine
+    template <typename Row>
+    void sort_records(const string& engine, vector<Row>& records) {
+        if (engine == "keyindex")
+            sort_by_key_index(records, [this](vector<KeyIndex>& keys) { classic_quick_sort(keys); });
+        else if (engine == "introsort") {
+            if (worker_threads == 1) {
+                IntroSort<Row>(nullptr, parallel_cutoff).sort(records);
+            } else {
+                ThreadPool pool(worker_threads);
+                IntroSort<Row>(&pool, parallel_cutoff).sort(records);
+            }
         }
+        else
+            classic_quick_sort(records);
+    }
 
-        // Read each line of the file
-        while (getline(file, line)) {
-            stringstream ss(line);       // Create a string stream from the line
-            string numStr, word;         // To hold parsed values
+    // The classic quick sort with the --partition kernel (see sort_search.hpp)
+    // T is any pair-like element ordered by its .first (Record or KeyIndex)
+    template <typename T>
+    void classic_quick_sort(vector<T>& v) {
+        if (use_block_partition)
+            quick_sort<BlockPartition>(v.begin(), v.end());
+        else
+            quick_sort<LomutoPartition>(v.begin(), v.end());
+    }
 
-            // Try to split the line by comma and read two values
-            if (getline(ss, numStr, ',') && getline(ss, word)) {
-                try {
-                    int number = stoi(numStr);  // Try converting the first value to an integer
-                    data.emplace_back(number, word);  // Store the pair in the vector
-                } catch (...) {
-                    // If conversion fails, skip the line and warn
-                    cerr << "Warning: Skipping row with invalid integer value: " << line << endl;
-                }
-            } else {
+    // Memory-map the CSV or binary dataset file and load it into integer-string records
+    void load_csv_data(const string& filename, Dataset& dataset, unsigned threads) {
+        bool opened = load_dataset(filename, dataset, [](RowError error, size_t, string_view line) {
+            if (error == RowError::NonInteger)
+                // If conversion fails, skip the line and warn
+                cerr << "Warning: Skipping row with invalid integer value: " << line << endl;
+            else
                 // If line is malformed (missing comma/column), skip it and warn
                 cerr << "Warning: Skipping malformed row (expected 2 columns): " << line << endl;
-            }
-        }
+        }, threads);
 
-        file.close();
-        return data;   
+        // If the file couldn't be opened, show an error
+        if (!opened)
+            cerr << "Error: The file '" << filename << "' could not be found or opened." << endl;
     }
 
-    // Write sorted data to a new CSV file
-    void save_to_csv(const vector<pair<int, string>>& data, const string& filename) {
-        ofstream file(filename);  
+    // Write sorted data to a new CSV file; formatting overlaps the writes
+    // unless the run is serial (--threads=1)
+    template <typename Row>
+    void save_to_csv(const vector<Row>& data, const string& filename) {
+        CsvBlockWriter file(filename, 8 << 20, worker_threads != 1);
 
         // Check if file is ready to be written
         if (!file.is_open()) {
@@ -105,59 +368,18 @@ private:
 
         // Write each record to the file in CSV format
         for (const auto& record : data) {
-            file << record.first << "," << record.second << "\n";
-        }
-
-        file.close(); 
-    }
-
-    // Recursive Quick Sort function
-    void quick_sort(vector<pair<int, string>>& arr, int low, int high) {
-        if (low < high) {
-            // Partition the array and get the pivot index
-            //This line calls the partition function, which rearranges the array so that all elements 
-            // less than or equal to the pivot are on the left, 
-            // and returns the index where the pivot ends up. The result is stored in pivot_index.
-            int pivot_index = partition(arr, low, high);
-
-            // Recursively sort elements before the pivot
-            //calls the quick_sort function recursively to sort the left part of the array, 
-            // from the low index up to one position before the pivot. 
-            // This ensures that all elements less than or equal to the pivot are sorted before the pivot in the array. 
-            // It is a key step in the divide-and-conquer approach of quick sort.
-            quick_sort(arr, low, pivot_index - 1);
-
-            // Recursively sort elements after the pivot
-            //This line recursively sorts the right part of the array, 
-            // from just after the pivot (pivot_index + 1) to the high index, 
-            // ensuring all elements greater than the pivot are sorted.
-            quick_sort(arr, pivot_index + 1, high);
+            file.write_record(record.first, record_word(record));
         }
-    }
 
-    // Partition function to rearrange elements around the pivot
-    int partition(vector<pair<int, string>>& arr, int low, int high) {
-        int pivot = arr[high].first;  // Choose last element's integer as pivot
-        int i = low - 1;              // Index of smaller element
-
-        // Rearrange elements based on pivot
-        for (int j = low; j < high; ++j) { // Loop through the subarray from low to high - 1
-            if (arr[j].first <= pivot) {  // If current element is less than or equal to the pivot
-                ++i;                      // Move the boundary for smaller elements to the right
-                swap(arr[i], arr[j]);  // Swap current element with the element at the new boundary
-            }
-        }
-
-        swap(arr[i + 1], arr[high]);   // This line swaps the pivot element (at arr[high]) 
-                                       // with the first element greater than the pivot (at arr[i + 1]), 
-                                       // placing the pivot in its correct sorted position in the array.
-        return i + 1;                  // Return the pivot index
+        file.flush();
+        if (!file.good())
+            cerr << "Error: Unable to write to the file '" << filename << "'." << endl;
     }
 };
 
 
-int main() {
+int main(int argc, char* argv[]) {
     TestQuickSort sorter; 
-    sorter.main();     
+    sorter.main(argc, argv);     
     return 0;              
 }
@@ -4,6 +4,8 @@
 #include <vector>
 #include <string>
 #include <limits>
+#include "binary_dataset.hpp"
+#include "sort_search.hpp"
 
 using namespace std;
 
@@ -14,14 +16,16 @@ public:
         cout << "Enter CSV file name: ";  // Prompt user to input CSV filename
         cin >> input_filename;
 
-        // Check if filename ends with ".csv"
-        if (input_filename.size() < 4 || input_filename.substr(input_filename.size() - 4) != ".csv") {
+        // Check if filename ends with ".csv" (or ".bin" for a binary dataset)
+        if (!has_dataset_extension(input_filename)) {
             cerr << "Error: Please provide a valid CSV file." << endl; // If not CSV, print error
             return;
         }
 
         // Step 1: Load entire CSV file data into memory
-        vector<pair<int, string>> full_data = read_data_from_csv(input_filename);
+        Dataset dataset;
+        read_data_from_csv(input_filename, dataset);
+        vector<Record>& full_data = dataset.rows;
         if (full_data.empty()) {
             cerr << "Error: Could not read data from " << input_filename << ". Please ensure the file exists." << endl; // Error if file empty or unreadable
             return;
@@ -57,7 +61,7 @@ public:
         }
 
         // Extract the subset of data between start_idx and end_idx (inclusive)
-        vector<pair<int, string>> data_subset(full_data.begin() + start_idx, full_data.begin() + end_idx + 1);
+        vector<Record> data_subset(full_data.begin() + start_idx, full_data.begin() + end_idx + 1);
 
         // Prepare output filename to record sorting steps
         string output_filename = "quick_sort_step_" + to_string(start_idx + 1) + "_" + to_string(end_idx + 1) + ".txt";
@@ -71,45 +75,30 @@ public:
         // Write initial state of subset to output file (formatted)
         output_file << "[" << join(data_subset) << "]\n";
 
-        // Call quick_sort on subset, passing output file for logging steps
-        quick_sort(data_subset, 0, data_subset.size() - 1, output_file);
+        // Quick sort the subset, logging the pivot index and array state after every partition
+        quick_sort(data_subset.begin(), data_subset.end(), FirstKey(), less<>(),
+                   [&](vector<Record>::iterator pivot) {
+                       output_file << "pi=" << (pivot - data_subset.begin()) << " [" << join(data_subset) << "]\n";
+                   });
 
         cout << "Sorting steps written to " << output_filename << endl;  // Notify user
     }
 
 private:
-    vector<pair<int, string>> read_data_from_csv(const string& filename) {
-        vector<pair<int, string>> data;
-        ifstream file(filename);
-        string line;
-        int row_num = 0;
-
-        if (!file.is_open()) {  // Check if file opens successfully
+    // Memory-map the CSV or binary dataset file and load it into (int, string) records
+    void read_data_from_csv(const string& filename, Dataset& dataset) {
+        bool opened = load_dataset(filename, dataset, [](RowError error, size_t row_num, string_view line) {
+            if (error == RowError::NonInteger)
+                cerr << "Skipping row " << row_num << " (invalid integer): " << line << endl;
+            else
+                cerr << "Skipping row " << row_num << " (malformed): " << line << endl;
+        });
+
+        if (!opened)  // Check if file opened successfully
             cerr << "File '" << filename << "' not found." << endl;
-            return data;         // Return empty vector on failure
-        }
-
-        // Read file line by line
-        while (getline(file, line)) {
-            row_num++;          // Keep track of line number for error messages
-            stringstream ss(line);
-            string num_str, word;
-            if (getline(ss, num_str, ',') && getline(ss, word)) {  // Parse integer and string separated by comma
-                try {
-                    int number = stoi(num_str);  // Convert string to integer
-                    data.emplace_back(number, word);  // Store tuple in vector
-                } catch (...) {
-                    cerr << "Skipping row " << row_num << " (invalid integer): " << line << endl; // Error on conversion
-                }
-            } else {
-                cerr << "Skipping row " << row_num << " (malformed): " << line << endl;  // If row format incorrect
-            }
-        }
-
-        return data;  // Return parsed data vector
     }
 
-    string join(const vector<pair<int, string>>& data) {
+    string join(const vector<Record>& data) {
         stringstream ss;
         // Format vector data into "int/string, int/string, ..." string
         for (size_t i = 0; i < data.size(); ++i) {
@@ -118,38 +107,6 @@ private:
         }
         return ss.str();  // Return formatted string
     }
-
-    void quick_sort(vector<pair<int, string>>& array, int low, int high, ofstream& log) {
-        if (low < high) {
-            // Partition array and get pivot index
-            int pivot_index = partition(array, low, high, log);
-
-            // Log pivot index and current state of array after partition
-            log << "pi=" << pivot_index << " [" << join(array) << "]\n";
-
-            // Recursively sort elements before pivot
-            quick_sort(array, low, pivot_index - 1, log);
-
-            // Recursively sort elements after pivot
-            quick_sort(array, pivot_index + 1, high, log);
-        }
-    }
-
-    int partition(vector<pair<int, string>>& array, int low, int high, ofstream& log) {
-        int pivot = array[high].first;  // Choose last element as pivot
-        int i = low - 1;                // Index of smaller element
-
-        for (int j = low; j < high; ++j) {
-            // If current element is less than or equal to pivot
-            if (array[j].first <= pivot) {
-                ++i;
-                swap(array[i], array[j]);  // Swap elements
-            }
-        }
-
-        swap(array[i + 1], array[high]);  // Place pivot in correct position
-        return i + 1;                     // Return pivot index
-    }
 };
 
 int main() {
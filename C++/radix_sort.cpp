@@ -0,0 +1,155 @@
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <iomanip>
+#include "cli_options.hpp"
+#include "binary_dataset.hpp"
+#include "compact_record.hpp"
+#include "csv_writer.hpp"
+#include "key_index_sort.hpp"
+#include "parallel_radix_sort.hpp"
+#include "radix_sort.hpp"
+
+using namespace std;
+using namespace std::chrono;
+
+class TestRadixSort {
+public:
+    // Optional arguments:
+    //   --threads=N       CSV parser and parallel engine threads (default: one per core, 1 = serial)
+    //   --engine=NAME     lsd      - single-threaded LSD radix sort (default)
+    //                     parallel - MSD split on the top digit with per-thread histograms and
+    //                                scatter, then per-bucket LSD sorts on a thread pool
+    //   --record=NAME     pair    - (int, string_view) records, 24 bytes each (default)
+    //                     compact - 16-byte records with the word copied inline (see compact_record.hpp)
+    void main(int argc, char* argv[]) {
+        unsigned threads;
+        if (!option_threads(argc, argv, threads)) {
+            cerr << "Error: Invalid thread count '" << option_value(argc, argv, "threads") << "'." << endl;
+            return;
+        }
+        string engine = option_value(argc, argv, "engine", "lsd");
+        if (engine != "lsd" && engine != "parallel") {
+            cerr << "Error: Unknown sort engine '" << engine << "'." << endl;
+            return;
+        }
+        string record_layout;
+        if (!option_record_layout(argc, argv, record_layout))
+            return;
+
+        string input_filename;
+        cout << "Enter CSV file name: ";  // Ask user to enter CSV file name
+        cin >> input_filename;
+
+        // Check if file name ends with ".csv" (or ".bin" for a binary dataset)
+        if (!has_dataset_extension(input_filename)) {
+            cerr << "Error: Please provide a valid CSV file." << endl;
+            return;
+        }
+
+        // Read data from CSV file into vector of (int, string) records
+        Dataset dataset;
+        read_data_from_csv(input_filename, dataset, threads);
+        vector<Record>& data = dataset.rows;
+
+        // Check if data was loaded successfully
+        if (data.empty()) {
+            cerr << "Error: Could not read data from " << input_filename << endl;
+            return;
+        }
+
+        // Compact layout: copy the rows into 16-byte records and sort those instead
+        if (record_layout == "compact") {
+            vector<CompactRecord> compact;
+            if (!compact_loaded_rows(data, compact, input_filename))
+                return;
+            sort_and_save(engine, compact, threads);
+            return;
+        }
+        sort_and_save(engine, data, threads);
+    }
+
+private:
+    // Time the radix sort of the loaded rows (Record or CompactRecord), then write them out
+    template <typename Row>
+    void sort_and_save(const string& engine, vector<Row>& data, unsigned threads) {
+        // Record start time before sorting
+        auto start_time = high_resolution_clock::now();
+
+        // Radix sort the packed (key, row) array, then move each record once
+        RadixPhaseTimes phases;
+        if (engine == "parallel") {
+            ThreadPool pool(threads);
+            ParallelRadixSort<KeyIndex> sorter(pool);
+            sort_by_key_index(data, [&sorter](vector<KeyIndex>& keys) { sorter.sort(keys); });
+            phases = sorter.phase_times();
+        } else {
+            sort_by_key_index(data, [](vector<KeyIndex>& keys) { lsd_radix_sort(keys); });
+        }
+
+        // Record end time after sorting
+        auto end_time = high_resolution_clock::now();
+
+        // Calculate duration in milliseconds
+        duration<double, milli> duration = end_time - start_time;
+        cout << fixed << setprecision(3);
+        cout << "Running time: " << duration.count() << " ms" << endl;  // Print running time with 3 decimal places
+        if (engine == "parallel") {
+            // Where the time went inside the parallel engine
+            cout << "  Histogram phase: " << phases.histogram_ms << " ms" << endl;
+            cout << "  Scatter phase: " << phases.scatter_ms << " ms" << endl;
+            cout << "  Local sort phase: " << phases.local_sort_ms << " ms" << endl;
+            cout << "  Key packing and record permutation: "
+                 << duration.count() - phases.histogram_ms - phases.scatter_ms - phases.local_sort_ms << " ms" << endl;
+        }
+
+        // Create output filename based on data size
+        string output_filename = "radix_sort_" + to_string(data.size()) + ".csv";
+
+        // Write sorted data to output CSV file
+        write_data_to_csv(data, output_filename, threads);
+        cout << "Sorted data written to " << output_filename << endl;  // Notify user
+    }
+
+    // Memory-map the CSV or binary dataset file and load it into (int, string) records
+    void read_data_from_csv(const string& filename, Dataset& dataset, unsigned threads) {
+        bool opened = load_dataset(filename, dataset, [](RowError error, size_t, string_view line) {
+            if (error == RowError::NonInteger)
+                cerr << "Skipping row due to non-integer value: " << line << endl;
+            else
+                cerr << "Skipping malformed row: " << line << endl;
+        }, threads);
+
+        // Check if file opened successfully
+        if (!opened)
+            cerr << "Error: File '" << filename << "' not found." << endl;
+    }
+
+    // Write sorted data to CSV file, one "int,string" line per record; formatting
+    // overlaps the writes unless the run is serial (threads == 1)
+    template <typename Row>
+    void write_data_to_csv(const vector<Row>& data, const string& filename, unsigned threads) {
+        CsvBlockWriter file(filename, 8 << 20, threads != 1);
+
+        // Check if file opened successfully
+        if (!file.is_open()) {
+            cerr << "An error occurred while writing the CSV: " << filename << endl;
+            return;
+        }
+
+        for (const auto& item : data) {
+            file.write_record(item.first, record_word(item));
+        }
+        file.flush();
+        if (!file.good())
+            cerr << "An error occurred while writing the CSV: " << filename << endl;
+    }
+};
+
+int main(int argc, char* argv[]) {
+    TestRadixSort sorter;
+    sorter.main(argc, argv);
+    return 0;
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// LSD radix sort for pair-like elements keyed by an int .first.
+//
+// Keys are mapped to unsigned with the sign bit flipped so negative values
+// order correctly, then sorted in three stable counting passes of 11, 11 and
+// 10 bits. All three histograms are built in one read of the input, and a
+// pass whose digit is the same for every key is skipped (common when keys
+// stay below 2^21 or 2^22). Being stable, the result equals merge sort's.
+
+constexpr int kRadixBits = 11;
+constexpr int kRadixPasses = 3;
+constexpr size_t kRadixBuckets = size_t(1) << kRadixBits;
+
+inline uint32_t radix_key(int key) {
+    return static_cast<uint32_t>(key) ^ 0x80000000u;
+}
+
+inline uint32_t radix_digit(uint32_t key, int pass) {
+    return (key >> (pass * kRadixBits)) & (kRadixBuckets - 1);
+}
+
+// Stable sort of v[0, n) by the low `passes` digits, using scratch[0, n).
+// Histograms are built in one read and passes where every key shares the
+// digit are skipped. Returns whichever of v or scratch holds the result.
+template <typename T>
+T* lsd_radix_sort_span(T* v, T* scratch, size_t n, int passes) {
+    if (n < 2)
+        return v;
+
+    std::vector<size_t> counts(passes * kRadixBuckets, 0);
+    for (size_t i = 0; i < n; ++i) {
+        uint32_t key = radix_key(v[i].first);
+        for (int pass = 0; pass < passes; ++pass)
+            ++counts[pass * kRadixBuckets + radix_digit(key, pass)];
+    }
+
+    const uint32_t first_key = radix_key(v[0].first);
+    T* src = v;
+    T* dst = scratch;
+    for (int pass = 0; pass < passes; ++pass) {
+        size_t* count = &counts[pass * kRadixBuckets];
+
+        // Every key has the same digit: this pass would not move anything
+        if (count[radix_digit(first_key, pass)] == n)
+            continue;
+
+        // Exclusive prefix sum turns counts into bucket start positions
+        size_t sum = 0;
+        for (size_t b = 0; b < kRadixBuckets; ++b) {
+            size_t c = count[b];
+            count[b] = sum;
+            sum += c;
+        }
+
+        // Stable scatter into the other buffer
+        for (size_t i = 0; i < n; ++i)
+            dst[count[radix_digit(radix_key(src[i].first), pass)]++] = std::move(src[i]);
+        std::swap(src, dst);
+    }
+    return src;
+}
+
+template <typename T>
+void lsd_radix_sort(std::vector<T>& v) {
+    std::vector<T> buffer(v.size());
+    if (lsd_radix_sort_span(v.data(), buffer.data(), v.size(), kRadixPasses) != v.data())
+        v.swap(buffer);
+}
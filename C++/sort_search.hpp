@@ -0,0 +1,479 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// The classic merge sort, quick sort and binary search, written once over
+// random-access iterators instead of vector<Record>. Every algorithm takes
+//   key  - extracts the sort key from an element (default: its .first)
+//   less - strict weak order on keys (default: operator<)
+// as template parameters, so the comparisons inline exactly as the old
+// hand-written `.first <=` did and the same code sorts Records, KeyIndex
+// pairs, descending orders, int64 or composite keys. Each also takes an
+// optional hook the step tools use to log progress; the default NoStep
+// compiles away, like NoProbeCount in probe_search.hpp.
+
+// Key extractor for pair-like elements (Record, CompactRecord, KeyIndex)
+struct FirstKey {
+    template <typename T>
+    const auto& operator()(const T& element) const { return element.first; }
+};
+
+// Key extractor for elements that are their own key
+struct IdentityKey {
+    template <typename T>
+    const T& operator()(const T& element) const { return element; }
+};
+
+// Hook that ignores its arguments
+struct NoStep {
+    template <typename... Args>
+    void operator()(const Args&...) const {}
+};
+
+namespace sort_search_detail {
+
+template <typename It>
+using Element = typename std::iterator_traits<It>::value_type;
+
+// Merge [first, mid) and [mid, last) back into place through temporary copies
+// of both halves; an equal key takes the left element first, so the sort is stable
+template <typename It, typename Key, typename Less>
+void merge_halves(It first, It mid, It last, Key& key, Less& less) {
+    std::vector<Element<It>> left(first, mid);
+    std::vector<Element<It>> right(mid, last);
+    auto i = left.begin(), j = right.begin();
+    It out = first;
+    while (i != left.end() && j != right.end()) {
+        if (!less(key(*j), key(*i)))   // left <= right
+            *out++ = *i++;
+        else
+            *out++ = *j++;
+    }
+    while (i != left.end())
+        *out++ = *i++;
+    while (j != right.end())
+        *out++ = *j++;
+}
+
+template <typename It, typename Key, typename Less, typename OnMerge>
+void merge_sort_range(It first, It last, Key& key, Less& less, OnMerge& on_merge) {
+    auto n = last - first;
+    if (n < 2)
+        return;
+    It mid = first + (n - 1) / 2 + 1;   // Left half gets the extra element, as (left + right) / 2 did
+    merge_sort_range(first, mid, key, less, on_merge);
+    merge_sort_range(mid, last, key, less, on_merge);
+    merge_halves(first, mid, last, key, less);
+    on_merge(first, last);
+}
+
+// Merge src[lo, mid) and src[mid, hi) into dst[lo, hi) by moving
+template <typename Src, typename Dst, typename Key, typename Less>
+void merge_into(Src src, Dst dst, std::ptrdiff_t lo, std::ptrdiff_t mid, std::ptrdiff_t hi, Key& key, Less& less) {
+    std::ptrdiff_t i = lo, j = mid, k = lo;
+    while (i < mid && j < hi) {
+        if (!less(key(src[j]), key(src[i])))   // <= keeps equal keys in input order
+            dst[k++] = std::move(src[i++]);
+        else
+            dst[k++] = std::move(src[j++]);
+    }
+    while (i < mid)
+        dst[k++] = std::move(src[i++]);
+    while (j < hi)
+        dst[k++] = std::move(src[j++]);
+}
+
+// Sort dst[lo, hi) from the same elements in src[lo, hi); the halves are
+// sorted into src first, with the roles swapped
+template <typename Src, typename Dst, typename Key, typename Less>
+void buffered_sort_into(Src src, Dst dst, std::ptrdiff_t lo, std::ptrdiff_t hi, Key& key, Less& less) {
+    if (hi - lo < 2)
+        return;
+    std::ptrdiff_t mid = lo + (hi - lo - 1) / 2 + 1;   // Same split as merge_sort
+    buffered_sort_into(dst, src, lo, mid, key, less);
+    buffered_sort_into(dst, src, mid, hi, key, less);
+    merge_into(src, dst, lo, mid, hi, key, less);
+}
+
+}  // namespace sort_search_detail
+
+// Stable top-down merge sort of [first, last). Each merge copies its two
+// halves into temporaries; on_merge(first, last) is called after every merge
+// with the range just merged.
+template <typename RandomIt, typename Key = FirstKey, typename Less = std::less<>, typename OnMerge = NoStep>
+void merge_sort(RandomIt first, RandomIt last, Key key = Key(), Less less = Less(), OnMerge on_merge = OnMerge()) {
+    sort_search_detail::merge_sort_range(first, last, key, less, on_merge);
+}
+
+// The same merge sort with a single scratch buffer allocated up front. Both
+// copies start equal; each level sorts its halves into one and merges them
+// into the other, so nothing is copied back and no temporaries are allocated
+// per merge. Same split points and tie rule, so the result is identical.
+template <typename RandomIt, typename Key = FirstKey, typename Less = std::less<>>
+void buffered_merge_sort(RandomIt first, RandomIt last, Key key = Key(), Less less = Less()) {
+    auto n = last - first;
+    if (n < 2)
+        return;
+    std::vector<sort_search_detail::Element<RandomIt>> buffer(first, last);   // The only allocation
+    sort_search_detail::buffered_sort_into(buffer.begin(), first, 0, n, key, less);
+}
+
+namespace sort_search_detail {
+
+// Natural runs shorter than this are extended by binary insertion sort
+constexpr std::ptrdiff_t kMinRun = 32;
+
+// A merge switches to galloping once one side wins this many times in a row
+constexpr std::ptrdiff_t kMinGallop = 7;
+
+// First element of [first, last) for which is_after holds, where is_after is
+// false up to some point and true from there on. Probes 1, 2, 4, ... elements
+// ahead before bisecting, so a short answer costs O(log distance).
+template <typename It, typename IsAfter>
+It gallop(It first, It last, IsAfter is_after) {
+    std::ptrdiff_t n = last - first, lo = 0, step = 1;   // [first, first + lo) are all before
+    while (lo + step <= n && !is_after(first[lo + step - 1])) {
+        lo += step;
+        step *= 2;
+    }
+    std::ptrdiff_t hi = std::min(n, lo + step);
+    using Value = decltype(*first);
+    return std::partition_point(first + lo, first + hi, [&](Value element) { return !is_after(element); });
+}
+
+// Stable binary insertion sort of [first, last), where [first, sorted_end) is already sorted
+template <typename It, typename Key, typename Less>
+void binary_insertion_sort(It first, It sorted_end, It last, Key& key, Less& less) {
+    for (It it = sorted_end; it != last; ++it) {
+        Element<It> value = std::move(*it);
+        It pos = std::upper_bound(first, it, key(value), [&](const auto& k, const Element<It>& e) { return less(k, key(e)); });
+        std::move_backward(pos, it, it + 1);
+        *pos = std::move(value);
+    }
+}
+
+// Length of the natural run starting at first, made ascending: a strictly
+// descending run is reversed in place (strictly, so no equal keys swap)
+template <typename It, typename Key, typename Less>
+std::ptrdiff_t natural_run(It first, It last, Key& key, Less& less) {
+    It end = first + 1;
+    if (end == last)
+        return 1;
+    if (less(key(*end), key(*first))) {
+        while (end + 1 != last && less(key(end[1]), key(*end)))
+            ++end;
+        ++end;
+        std::reverse(first, end);
+    } else {
+        while (end + 1 != last && !less(key(end[1]), key(*end)))
+            ++end;
+        ++end;
+    }
+    return end - first;
+}
+
+// Powersort priority of the boundary between runs [s1, s1 + n1) and
+// [s1 + n1, s1 + n1 + n2) of an n-element array: the depth at which the
+// boundary would split a perfectly balanced merge tree over [0, n)
+inline int node_power(std::ptrdiff_t s1, std::ptrdiff_t n1, std::ptrdiff_t n2, std::ptrdiff_t n) {
+    std::ptrdiff_t a = 2 * s1 + n1;   // Twice the midpoint of the first run
+    std::ptrdiff_t b = a + n1 + n2;   // Twice the midpoint of the second run
+    int power = 0;
+    for (;;) {
+        ++power;
+        if (a >= n) {
+            a -= n;
+            b -= n;
+        } else if (b >= n) {
+            break;   // The midpoints first differ in this bit
+        }
+        a <<= 1;
+        b <<= 1;
+    }
+    return power;
+}
+
+// Stable merge of the adjacent sorted runs [first, mid) and [mid, last).
+// Left elements already not after the right run's first, and right elements
+// already not before the left run's last, are skipped with a gallop. The rest
+// of the left run moves to buffer and merges forward; once one side keeps
+// winning the merge gallops over it to move whole blocks at a time.
+template <typename It, typename Key, typename Less>
+void gallop_merge(It first, It mid, It last, std::vector<Element<It>>& buffer, Key& key, Less& less) {
+    using Item = const Element<It>&;
+    first = gallop(first, mid, [&](Item e) { return less(key(*mid), key(e)); });
+    if (first == mid)
+        return;   // Already in order
+    last = gallop(mid, last, [&](Item e) { return !less(key(e), key(mid[-1])); });
+
+    buffer.assign(std::make_move_iterator(first), std::make_move_iterator(mid));
+    auto b = buffer.begin(), b_end = buffer.end();
+    It r = mid, out = first;
+    while (b != b_end && r != last) {
+        std::ptrdiff_t left_wins = 0, right_wins = 0;
+        while (left_wins < kMinGallop && right_wins < kMinGallop) {
+            if (less(key(*r), key(*b))) {
+                *out++ = std::move(*r++);
+                ++right_wins;
+                left_wins = 0;
+                if (r == last)
+                    break;
+            } else {
+                *out++ = std::move(*b++);
+                ++left_wins;
+                right_wins = 0;
+                if (b == b_end)
+                    break;
+            }
+        }
+        // Gallop: move runs of left elements not after *r, then right elements before *b
+        while (b != b_end && r != last && (left_wins >= kMinGallop || right_wins >= kMinGallop)) {
+            auto b_stop = gallop(b, b_end, [&](Item e) { return less(key(*r), key(e)); });
+            left_wins = b_stop - b;
+            out = std::move(b, b_stop, out);
+            b = b_stop;
+            if (b == b_end)
+                break;
+            It r_stop = gallop(r, last, [&](Item e) { return !less(key(e), key(*b)); });
+            right_wins = r_stop - r;
+            out = std::move(r, r_stop, out);
+            r = r_stop;
+        }
+    }
+    std::move(b, b_end, out);   // Anything left of the right run is already in place
+}
+
+}  // namespace sort_search_detail
+
+// Adaptive stable merge sort (powersort). The input is cut into natural runs,
+// ascending or strictly descending (reversed in place), each extended to
+// kMinRun elements by binary insertion sort; runs are merged as the powersort
+// stack policy dictates, with galloping merges. Sorted or reversed input costs
+// n - 1 comparisons and k presorted runs about n log k. Stable, so the result
+// is identical to merge_sort.
+template <typename RandomIt, typename Key = FirstKey, typename Less = std::less<>>
+void adaptive_merge_sort(RandomIt first, RandomIt last, Key key = Key(), Less less = Less()) {
+    using namespace sort_search_detail;
+    const std::ptrdiff_t n = last - first;
+    if (n < 2)
+        return;
+
+    struct Run {
+        std::ptrdiff_t start, length;
+        int power;   // Of the boundary with the next run up the stack
+    };
+    std::vector<Run> stack;
+    std::vector<Element<RandomIt>> buffer;
+    auto merge_top_two = [&]() {
+        Run& below = stack[stack.size() - 2];
+        const Run& top = stack.back();
+        gallop_merge(first + below.start, first + top.start, first + top.start + top.length, buffer, key, less);
+        below.length += top.length;
+        stack.pop_back();
+    };
+
+    for (std::ptrdiff_t start = 0; start < n;) {
+        std::ptrdiff_t length = natural_run(first + start, last, key, less);
+        if (length < kMinRun) {
+            std::ptrdiff_t extended = std::min(kMinRun, n - start);
+            binary_insertion_sort(first + start, first + start + length, first + start + extended, key, less);
+            length = extended;
+        }
+        if (!stack.empty()) {
+            int power = node_power(stack.back().start, stack.back().length, length, n);
+            while (stack.size() > 1 && stack[stack.size() - 2].power > power)
+                merge_top_two();
+            stack.back().power = power;
+        }
+        stack.push_back({start, length, 0});
+        start += length;
+    }
+    while (stack.size() > 1)
+        merge_top_two();
+}
+
+// Lomuto partition of [first, last) around the key of its last element:
+// elements whose key is not greater than the pivot move to the front, in scan
+// order, and the pivot lands right after them. Returns the pivot's position.
+struct LomutoPartition {
+    template <typename RandomIt, typename Key, typename Less>
+    RandomIt operator()(RandomIt first, RandomIt last, Key& key, Less& less) const {
+        using std::swap;
+        RandomIt high = last - 1;
+        const auto pivot = key(*high);   // A copy: the pivot element moves during the scan
+        RandomIt boundary = first;       // [first, boundary) are <= pivot
+        for (RandomIt it = first; it != high; ++it) {
+            if (!less(pivot, key(*it))) {
+                swap(*boundary, *it);
+                ++boundary;
+            }
+        }
+        swap(*boundary, *high);
+        return boundary;
+    }
+};
+
+// Branchless block variant of LomutoPartition (BlockQuicksort style, one-sided).
+// For each block of kBlock elements, the offsets of those <= pivot are first
+// recorded without branching (the comparison result just advances the count),
+// then all of them are swapped to the boundary in one batch. Lomuto never
+// touches elements ahead of its scan, so this performs exactly the same swaps
+// in the same order: the result is identical, ties included.
+struct BlockPartition {
+    static constexpr std::ptrdiff_t kBlock = 128;   // Offsets within a block fit in one byte
+
+    template <typename RandomIt, typename Key, typename Less>
+    RandomIt operator()(RandomIt first, RandomIt last, Key& key, Less& less) const {
+        using std::swap;
+        RandomIt high = last - 1;
+        const auto pivot = key(*high);
+        RandomIt boundary = first;
+        unsigned char offsets[kBlock];
+
+        for (RandomIt start = first; start < high;) {
+            std::ptrdiff_t block = std::min<std::ptrdiff_t>(kBlock, high - start);
+
+            // Pass 1: record offsets of elements <= pivot (no data-dependent branch)
+            std::ptrdiff_t count = 0;
+            for (std::ptrdiff_t k = 0; k < block; ++k) {
+                offsets[count] = static_cast<unsigned char>(k);
+                count += !less(pivot, key(start[k]));
+            }
+
+            // Pass 2: swap them to the boundary in order
+            for (std::ptrdiff_t t = 0; t < count; ++t)
+                swap(boundary[t], start[offsets[t]]);
+            boundary += count;
+            start += block;
+        }
+
+        swap(*boundary, *high);
+        return boundary;
+    }
+};
+
+namespace sort_search_detail {
+
+template <typename It, typename Partition, typename Key, typename Less, typename OnPartition>
+void quick_sort_range(It first, It last, Partition& partition, Key& key, Less& less, OnPartition& on_partition) {
+    if (last - first < 2)
+        return;
+    It pivot = partition(first, last, key, less);
+    on_partition(pivot);
+    quick_sort_range(first, pivot, partition, key, less, on_partition);
+    quick_sort_range(pivot + 1, last, partition, key, less, on_partition);
+}
+
+}  // namespace sort_search_detail
+
+// Quick sort of [first, last) with the last element of each range as the
+// pivot. Not stable, and quadratic (with recursion as deep as the range) on
+// sorted input or many equal keys; IntroSort is the robust engine.
+// on_partition(pivot) is called after every partition.
+template <typename Partition = LomutoPartition, typename RandomIt, typename Key = FirstKey, typename Less = std::less<>,
+          typename OnPartition = NoStep>
+void quick_sort(RandomIt first, RandomIt last, Key key = Key(), Less less = Less(),
+                OnPartition on_partition = OnPartition()) {
+    Partition partition;
+    sort_search_detail::quick_sort_range(first, last, partition, key, less, on_partition);
+}
+
+namespace sort_search_detail {
+
+// Sort the keys at first, the middle and last - 1, then swap the median to
+// last - 1, where the partition kernels take their pivot from
+template <typename It, typename Key, typename Less>
+void median_of_three_to_back(It first, It last, Key& key, Less& less) {
+    using std::swap;
+    It a = first, b = first + (last - first) / 2, c = last - 1;
+    if (less(key(*b), key(*a)))
+        swap(*a, *b);
+    if (less(key(*c), key(*b))) {
+        swap(*b, *c);
+        if (less(key(*b), key(*a)))
+            swap(*a, *b);
+    }
+    swap(*b, *c);
+}
+
+template <typename It, typename Partition, typename Key, typename Less, typename OnPartition>
+void partial_sort_range(It first, It last, It lo, It hi, int depth_limit, Partition& partition, Key& key,
+                        Less& less, OnPartition& on_partition) {
+    while (last - first > 1 && first < hi && lo < last) {
+        if (depth_limit-- == 0) {
+            // Too many poor pivots: finish with a heap, O(n log n) at worst
+            auto before = [&](const Element<It>& a, const Element<It>& b) { return less(key(a), key(b)); };
+            std::partial_sort(first, std::min(hi, last), last, before);
+            return;
+        }
+        if (last - first >= 3)
+            median_of_three_to_back(first, last, key, less);
+        It pivot = partition(first, last, key, less);
+        on_partition(pivot);
+        partial_sort_range(first, pivot, lo, hi, depth_limit, partition, key, less, on_partition);
+        first = pivot + 1;
+    }
+}
+
+}  // namespace sort_search_detail
+
+// Partial quick sort: rearrange [first, last) so that [lo, hi) holds, in
+// order, the elements a full sort would put there, with nothing before lo
+// ordered after them and nothing from hi on ordered before them. A partition
+// is only followed into the sides that overlap [lo, hi), so k wanted
+// elements cost O(n + k log k) expected instead of O(n log n). Pivots are
+// the median of three, moved to the back for Partition; ranges still
+// unfinished after 2*log2(n) levels are completed by std::partial_sort, as
+// introsort falls back to heapsort. Not stable. on_partition(pivot) is
+// called after every partition.
+template <typename Partition = LomutoPartition, typename RandomIt, typename Key = FirstKey, typename Less = std::less<>,
+          typename OnPartition = NoStep>
+void partial_quick_sort(RandomIt first, RandomIt lo, RandomIt hi, RandomIt last, Key key = Key(), Less less = Less(),
+                        OnPartition on_partition = OnPartition()) {
+    int depth_limit = 0;
+    for (std::ptrdiff_t n = last - first; n > 1; n >>= 1)
+        depth_limit += 2;
+    Partition partition;
+    sort_search_detail::partial_sort_range(first, last, lo, hi, depth_limit, partition, key, less, on_partition);
+}
+
+// Introselect: move the element a full sort would put at nth there, with no
+// element before it ordered after it and none after it ordered before it.
+// O(n) expected, O(n log n) at worst; see partial_quick_sort.
+template <typename Partition = LomutoPartition, typename RandomIt, typename Key = FirstKey, typename Less = std::less<>,
+          typename OnPartition = NoStep>
+void quick_select(RandomIt first, RandomIt nth, RandomIt last, Key key = Key(), Less less = Less(),
+                  OnPartition on_partition = OnPartition()) {
+    if (nth != last)
+        partial_quick_sort<Partition>(first, nth, nth + 1, last, key, less, on_partition);
+}
+
+// Binary search of [first, last), sorted by key under less, for an element
+// whose key is equivalent to target. Returns it (any one of several equal
+// keys) or last if there is none. on_probe(it) is called for every element
+// read, before it is compared.
+template <typename RandomIt, typename Target, typename Key = FirstKey, typename Less = std::less<>,
+          typename OnProbe = NoStep>
+RandomIt binary_find(RandomIt first, RandomIt last, const Target& target, Key key = Key(), Less less = Less(),
+                     OnProbe&& on_probe = OnProbe()) {
+    std::ptrdiff_t low = 0;
+    std::ptrdiff_t high = (last - first) - 1;
+    while (low <= high) {
+        std::ptrdiff_t mid = (low + high) / 2;
+        on_probe(first + mid);
+        const auto& mid_key = key(first[mid]);
+        if (less(mid_key, target))
+            low = mid + 1;    // Target is greater: search the right half
+        else if (less(target, mid_key))
+            high = mid - 1;   // Target is smaller: search the left half
+        else
+            return first + mid;
+    }
+    return last;
+}
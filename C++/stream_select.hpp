@@ -0,0 +1,85 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "csv_loader.hpp"
+
+// Ranks [lo, hi) of a CSV file's stable sorted order, found in one pass over
+// the mapped file without building its rows: a bounded heap keeps the hi
+// best rows seen so far, worst on top, and a row that cannot displace the
+// top costs one key comparison. Only hi Records are ever held, and on random
+// input the heap changes about hi * ln(n / hi) times, so selecting a few
+// rows of a large file is O(n). With largest set, ranks count down from the
+// largest key (the tail of the sorted file) and the result is still written
+// in ascending order. Ties keep file order, so the rows are exactly those a
+// stable sort would put at those ranks.
+class StreamSelect {
+public:
+    StreamSelect(size_t lo, size_t hi, bool largest) : lo_(lo), hi_(hi), largest_(largest) {}
+
+    // Scan filename into dataset: dataset.rows receives the selected rows
+    // (their words point into dataset.file) and rows the number of valid rows
+    // read. Returns false if the file cannot be mapped.
+    template <typename OnBadRow>
+    bool run(const std::string& filename, Dataset& dataset, size_t& rows, OnBadRow on_bad_row) {
+        rows = 0;
+        dataset.rows.clear();
+        if (!dataset.file.open(filename))
+            return false;
+
+        std::vector<Entry> heap;   // Grows with the rows seen: hi_ may be far larger than the file
+        std::vector<Record> row;   // parse_csv_line's output, one row at a time
+        const char* p = dataset.file.data();
+        const char* end = p + dataset.file.size();
+        size_t row_num = 0;
+        auto before = [this](const Entry& a, const Entry& b) { return is_before(a, b); };
+
+        while (p < end) {
+            const char* nl = static_cast<const char*>(memchr(p, '\n', end - p));
+            const char* line_end = nl ? nl : end;
+            row.clear();
+            parse_csv_line(p, line_end, ++row_num, row, on_bad_row);
+            p = line_end + 1;
+            if (row.empty())
+                continue;
+
+            Entry entry{row[0], rows++};
+            if (heap.size() < hi_) {
+                heap.push_back(entry);
+                std::push_heap(heap.begin(), heap.end(), before);
+            } else if (hi_ > 0 && is_before(entry, heap.front())) {
+                std::pop_heap(heap.begin(), heap.end(), before);
+                heap.back() = entry;
+                std::push_heap(heap.begin(), heap.end(), before);
+            }
+        }
+
+        // Best first; drop the ranks below lo, then turn a largest-first run ascending
+        std::sort_heap(heap.begin(), heap.end(), before);
+        for (size_t i = lo_; i < heap.size(); ++i)
+            dataset.rows.push_back(heap[i].row);
+        if (largest_)
+            std::reverse(dataset.rows.begin(), dataset.rows.end());
+        return true;
+    }
+
+private:
+    struct Entry {
+        Record row;
+        size_t order;   // Position among the valid rows, for stable ties
+    };
+
+    size_t lo_, hi_;
+    bool largest_;
+
+    // Whether a ranks ahead of b
+    bool is_before(const Entry& a, const Entry& b) const {
+        if (a.row.first != b.row.first)
+            return largest_ ? a.row.first > b.row.first : a.row.first < b.row.first;
+        return largest_ ? a.order > b.order : a.order < b.order;
+    }
+};
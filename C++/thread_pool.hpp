@@ -0,0 +1,162 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Work-stealing thread pool for fork-join style engines.
+// Each worker owns a deque: it pushes and pops its own tasks at the back
+// (newest first, good locality) and steals the oldest task from the front
+// of another worker's deque when it runs dry. Tasks submitted from outside
+// the pool are spread round-robin.
+class ThreadPool {
+public:
+    // threads == 0 means one worker per core
+    explicit ThreadPool(unsigned threads = 0) {
+        if (threads == 0)
+            threads = std::thread::hardware_concurrency();
+        if (threads == 0)
+            threads = 1;
+        for (unsigned i = 0; i < threads; ++i)
+            queues_.emplace_back(new WorkerQueue);
+        for (unsigned i = 0; i < threads; ++i)
+            workers_.emplace_back(&ThreadPool::worker_loop, this, i);
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(sleep_mutex_);
+            stopping_ = true;
+        }
+        wake_.notify_all();
+        for (auto& worker : workers_)
+            worker.join();
+    }
+
+    unsigned size() const { return static_cast<unsigned>(workers_.size()); }
+
+    // Queue a task; from a worker it goes on that worker's own deque
+    void submit(std::function<void()> task) {
+        size_t target = (current_pool() == this) ? current_index()
+                                                 : next_queue_.fetch_add(1) % queues_.size();
+        {
+            std::lock_guard<std::mutex> lock(queues_[target]->mutex);
+            queues_[target]->tasks.push_back(std::move(task));
+        }
+        {
+            std::lock_guard<std::mutex> lock(sleep_mutex_);
+            ++queued_;
+        }
+        wake_.notify_one();
+    }
+
+    // Run one queued task on the calling thread if any is available.
+    // Used by waiters so a blocked fork-join parent keeps doing useful work.
+    bool run_one() {
+        size_t home = (current_pool() == this) ? current_index() : 0;
+        std::function<void()> task;
+        if (!take(home, task))
+            return false;
+        task();
+        return true;
+    }
+
+private:
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    static ThreadPool*& current_pool() {
+        static thread_local ThreadPool* pool = nullptr;
+        return pool;
+    }
+
+    static size_t& current_index() {
+        static thread_local size_t index = 0;
+        return index;
+    }
+
+    // Pop from our own deque's back, else steal from another deque's front
+    bool take(size_t home, std::function<void()>& task) {
+        const size_t n = queues_.size();
+        for (size_t k = 0; k < n; ++k) {
+            WorkerQueue& q = *queues_[(home + k) % n];
+            std::lock_guard<std::mutex> lock(q.mutex);
+            if (q.tasks.empty())
+                continue;
+            if (k == 0) {
+                task = std::move(q.tasks.back());
+                q.tasks.pop_back();
+            } else {
+                task = std::move(q.tasks.front());
+                q.tasks.pop_front();
+            }
+            std::lock_guard<std::mutex> sleep_lock(sleep_mutex_);
+            --queued_;
+            return true;
+        }
+        return false;
+    }
+
+    void worker_loop(size_t index) {
+        current_pool() = this;
+        current_index() = index;
+        for (;;) {
+            std::function<void()> task;
+            if (take(index, task)) {
+                task();
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(sleep_mutex_);
+            wake_.wait(lock, [this] { return stopping_ || queued_ > 0; });
+            if (stopping_ && queued_ == 0)
+                return;
+        }
+    }
+
+    std::vector<std::unique_ptr<WorkerQueue>> queues_;
+    std::vector<std::thread> workers_;
+    std::atomic<size_t> next_queue_{0};
+
+    std::mutex sleep_mutex_;           // Guards queued_ and stopping_
+    std::condition_variable wake_;
+    size_t queued_ = 0;                // Tasks sitting in any deque
+    bool stopping_ = false;
+};
+
+// A set of tasks to fork on a pool and join with wait().
+// wait() runs queued tasks itself instead of blocking, so nested groups
+// (a task that forks and waits on its own children) cannot deadlock.
+class TaskGroup {
+public:
+    explicit TaskGroup(ThreadPool& pool) : pool_(pool) {}
+    ~TaskGroup() { wait(); }
+
+    void run(std::function<void()> task) {
+        pending_.fetch_add(1, std::memory_order_relaxed);
+        pool_.submit([this, task = std::move(task)]() {
+            task();
+            pending_.fetch_sub(1, std::memory_order_release);
+        });
+    }
+
+    void wait() {
+        while (pending_.load(std::memory_order_acquire) > 0) {
+            if (!pool_.run_one())
+                std::this_thread::yield();
+        }
+    }
+
+private:
+    ThreadPool& pool_;
+    std::atomic<size_t> pending_{0};
+};